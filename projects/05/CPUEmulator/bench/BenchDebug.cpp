@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Benchmark of the run loop with and without its debug features.
+ *
+ * Usage: benchDebug <program> [cycles] [repeats]
+ *
+ * Times a copy of the run loop as it was before debug support, the
+ * computer's own loop with no features on, and the loop with a breakpoint
+ * and a watchpoint that never trigger. The first two must run at the same
+ * speed and end in the same state; the best of the repeats is reported.
+ */
+
+#include "../src/Computer.h"
+#include "../src/Loader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// The plain loop of the computer without any debug support, on its own RAM
+struct Reference
+{
+    const Instruction *rom;
+    vector<uint16_t> ram;
+    uint16_t a, d, pc;
+    uint64_t cycles;
+
+    Reference(const Program &program) : rom{program.data()}, ram(RAM_SIZE), a{0}, d{0}, pc{0}, cycles{0}
+    {
+    }
+
+    void run(uint64_t count)
+    {
+        for(uint64_t i = 0; i < count; i++)
+        {
+            const Instruction &ins = rom[pc];
+
+            if(ins.halt)
+                break;
+
+            if(ins.address)
+            {
+                a = ins.word;
+                pc = (pc + 1) & 0x7FFF;
+            }
+            else
+            {
+                uint16_t address = a & 0x7FFF;
+                uint16_t out = compute(ins.alu, d, ins.useM ? ram[address] : a);
+
+                if(ins.dest & 1)
+                    ram[address] = out;
+                if(ins.dest & 2)
+                    d = out;
+                if(ins.dest & 4)
+                    a = out;
+
+                pc = jumps(ins.jump, out) ? address : (pc + 1) & 0x7FFF;
+            }
+
+            cycles++;
+        }
+    }
+};
+
+static double best(int repeats, const function<void()> &run)
+{
+    double fastest = 1e30;
+
+    for(int i = 0; i < repeats; i++)
+    {
+        auto start = chrono::steady_clock::now();
+        run();
+        auto end = chrono::steady_clock::now();
+
+        fastest = min(fastest, chrono::duration<double>(end - start).count());
+    }
+
+    return fastest;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 2)
+    {
+        cerr << "Usage: benchDebug <program> [cycles] [repeats]" << endl;
+        return 1;
+    }
+
+    try
+    {
+        uint64_t cycles = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100000000;
+        int repeats = argc > 3 ? atoi(argv[3]) : 5;
+
+        shared_ptr<const Program> program = Computer::decode(Loader::load(argv[1]), true);
+
+        uint64_t referenceCycles = 0, plainCycles = 0;
+        uint16_t referencePC = 0, plainPC = 0;
+        vector<uint16_t> referenceRAM, plainRAM;
+
+        double reference = best(repeats, [&]() {
+            Reference computer(*program);
+            computer.run(cycles);
+            referenceCycles = computer.cycles;
+            referencePC = computer.pc;
+            referenceRAM = computer.ram;
+        });
+
+        double plain = best(repeats, [&]() {
+            Computer computer;
+            computer.load(program);
+            computer.run(cycles);
+            plainCycles = computer.getCycles();
+            plainPC = computer.getPC();
+            plainRAM.assign(computer.getRAM(), computer.getRAM() + RAM_SIZE);
+        });
+
+        double breakpoint = best(repeats, [&]() {
+            Computer computer;
+            computer.load(program);
+            computer.setBreakpoint(ROM_SIZE - 1, true);
+            computer.run(cycles);
+        });
+
+        double watchpoint = best(repeats, [&]() {
+            Computer computer;
+            computer.load(program);
+            computer.setWatchpoint(RAM_SIZE - 1, true);
+            computer.run(cycles);
+        });
+
+        if(plainCycles != referenceCycles || plainPC != referencePC || plainRAM != referenceRAM)
+            throw runtime_error("The computer ends in a different state from the reference loop");
+
+        cout << referenceCycles << " cycles, best of " << repeats << endl;
+        cout << "without debug support: " << reference << " s (" << referenceCycles / reference / 1e6 << " M cycles/s)" << endl;
+        cout << "no features on:        " << plain << " s (" << plain / reference << "x)" << endl;
+        cout << "breakpoint:            " << breakpoint << " s (" << breakpoint / reference << "x)" << endl;
+        cout << "watchpoint:            " << watchpoint << " s (" << watchpoint / reference << "x)" << endl;
+    }
+    catch(exception &e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Benchmark of the Lockstep module against one Computer per instance.
+ *
+ * Usage: benchLockstep <program> [instances] [cycles]
+ *
+ * Every instance starts with random R0 and R1 and must end with the same
+ * RAM[2] and cycle count either way.
+ */
+
+#include "../src/Computer.h"
+#include "../src/Loader.h"
+#include "../src/Lockstep.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    if(argc < 2)
+    {
+        cerr << "Usage: benchLockstep <program> [instances] [cycles]" << endl;
+        return 1;
+    }
+
+    try
+    {
+        int instances = argc > 2 ? atoi(argv[2]) : 4096;
+        uint64_t cycles = argc > 3 ? strtoull(argv[3], nullptr, 10) : 100000;
+
+        shared_ptr<const Program> program = Computer::decode(Loader::load(argv[1]), true);
+
+        mt19937 random(1);
+        uniform_int_distribution<int> value(0, 999);
+        vector<uint16_t> r0(instances), r1(instances);
+        for(int i = 0; i < instances; i++)
+        {
+            r0[i] = static_cast<uint16_t>(value(random));
+            r1[i] = static_cast<uint16_t>(value(random));
+        }
+
+        vector<uint16_t> scalarResult(instances), lockstepResult(instances);
+        vector<uint64_t> scalarCycles(instances), lockstepCycles(instances);
+
+        auto start = chrono::steady_clock::now();
+
+        Computer computer;
+        for(int i = 0; i < instances; i++)
+        {
+            computer.load(program);
+            computer.poke(0, r0[i]);
+            computer.poke(1, r1[i]);
+            computer.poke(2, 0);
+            computer.run(cycles);
+            scalarResult[i] = computer.peek(2);
+            scalarCycles[i] = computer.getCycles();
+        }
+
+        auto middle = chrono::steady_clock::now();
+
+        uint64_t steps = 0, divergent = 0;
+        for(int first = 0; first < instances; first += LANES)
+        {
+            int count = min(LANES, instances - first);
+            Lockstep lanes(program, count);
+
+            for(int lane = 0; lane < count; lane++)
+            {
+                lanes.poke(lane, 0, r0[first + lane]);
+                lanes.poke(lane, 1, r1[first + lane]);
+            }
+
+            lanes.run(cycles);
+
+            for(int lane = 0; lane < count; lane++)
+            {
+                lockstepResult[first + lane] = lanes.peek(lane, 2);
+                lockstepCycles[first + lane] = lanes.getCycles(lane);
+            }
+
+            steps += lanes.getSteps();
+            divergent += lanes.getDivergentSteps();
+        }
+
+        auto end = chrono::steady_clock::now();
+
+        if(scalarResult != lockstepResult || scalarCycles != lockstepCycles)
+            throw runtime_error("Lockstep results differ from the computer's");
+
+        uint64_t total = 0;
+        for(uint64_t c : scalarCycles)
+            total += c;
+
+        double scalar = chrono::duration<double>(middle - start).count();
+        double lockstep = chrono::duration<double>(end - middle).count();
+
+        cout << instances << " instances, " << total << " cycles in all" << endl;
+        cout << "computer: " << scalar << " s (" << total / scalar / 1e6 << " M cycles/s)" << endl;
+        cout << "lockstep: " << lockstep << " s (" << total / lockstep / 1e6 << " M cycles/s), "
+             << steps << " steps of which " << divergent << " divergent" << endl;
+    }
+    catch(exception &e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Batch module.
+ */
+
+#include "Batch.h"
+#include "Lockstep.h"
+#include "TestScript.h"
+
+#include <atomic>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+const uint64_t DEFAULT_CYCLES{1000000};
+
+Batch::Batch(istream &manifest, const string &directory, bool haltDetection) :
+    cache{haltDetection}, haltDetection{haltDetection}, failures{0}
+{
+    parse(manifest, directory);
+}
+
+int Batch::getFailures()
+{
+    return failures;
+}
+
+static int parseAddress(const string &text)
+{
+    size_t consumed = 0;
+    int address = -1;
+
+    try
+    {
+        address = stoi(text, &consumed);
+    }
+    catch(logic_error &e)
+    {
+    }
+
+    if(consumed != text.size() || address < 0 || address >= RAM_SIZE)
+        throw runtime_error("'" + text + "' is not a RAM address");
+
+    return address;
+}
+
+// <address>:<value>[,<address>:<value>...]
+static vector<pair<int, uint16_t>> parseAssignments(const string &text)
+{
+    vector<pair<int, uint16_t>> assignments;
+    istringstream list(text);
+    string item;
+
+    while(getline(list, item, ','))
+    {
+        size_t colon = item.find(':');
+        if(colon == string::npos)
+            throw runtime_error("Expected <address>:<value> but got '" + item + "'");
+
+        int value = 0;
+        size_t consumed = 0;
+
+        try
+        {
+            value = stoi(item.substr(colon + 1), &consumed);
+        }
+        catch(logic_error &e)
+        {
+        }
+
+        if(consumed == 0 || consumed != item.size() - colon - 1 || value < -32768 || value > 65535)
+            throw runtime_error("'" + item.substr(colon + 1) + "' is not a 16-bit value");
+
+        assignments.push_back(make_pair(parseAddress(item.substr(0, colon)), static_cast<uint16_t>(value)));
+    }
+
+    return assignments;
+}
+
+void Batch::parse(istream &manifest, const string &directory)
+{
+    string line;
+    int line_no = 0;
+
+    while(getline(manifest, line))
+    {
+        line_no++;
+
+        size_t comment = line.find("//");
+        if(comment != string::npos)
+            line = line.substr(0, comment);
+
+        istringstream words(line);
+        string file;
+
+        if(!(words >> file))
+            continue;
+
+        Job job;
+        job.line = line_no;
+        job.file = (directory.empty() || file[0] == '/') ? file : directory + "/" + file;
+        job.script = file.size() > 4 && file.compare(file.size() - 4, 4, ".tst") == 0;
+        job.cycles = DEFAULT_CYCLES;
+        job.dumpFrom = 0;
+        job.dumpTo = -1;
+
+        try
+        {
+            string option;
+
+            while(words >> option)
+            {
+                size_t equals = option.find('=');
+                string key = option.substr(0, equals);
+                string value = equals == string::npos ? "" : option.substr(equals + 1);
+
+                if(key == "dump")
+                {
+                    size_t dash = value.find('-');
+                    if(dash == string::npos)
+                        throw runtime_error("Expected dump=<from>-<to>");
+                    job.dumpFrom = parseAddress(value.substr(0, dash));
+                    job.dumpTo = parseAddress(value.substr(dash + 1));
+                    if(job.dumpTo < job.dumpFrom)
+                        throw runtime_error("Empty dump range '" + value + "'");
+                }
+                else if(job.script)
+                    throw runtime_error("Option '" + key + "' only applies to ROM jobs");
+                else if(key == "set")
+                    job.set = parseAssignments(value);
+                else if(key == "expect")
+                    job.expect = parseAssignments(value);
+                else if(key == "cycles")
+                {
+                    try
+                    {
+                        job.cycles = stoull(value);
+                    }
+                    catch(logic_error &e)
+                    {
+                        throw runtime_error("'" + value + "' is not a cycle count");
+                    }
+                }
+                else
+                    throw runtime_error("Unknown option '" + key + "'");
+            }
+        }
+        catch(runtime_error &e)
+        {
+            throw runtime_error("Manifest (" + to_string(line_no) + "): " + e.what());
+        }
+
+        jobs.push_back(job);
+    }
+}
+
+Batch::Result Batch::execute(const Job &job)
+{
+    Result result;
+    Computer computer;
+
+    result.passed = true;
+    computer.setHaltDetection(haltDetection);
+
+    try
+    {
+        if(job.script)
+        {
+            ifstream input(job.file);
+            if(!input)
+                throw runtime_error("Could not open '" + job.file + "'");
+
+            size_t slash = job.file.find_last_of("/\\");
+            ostringstream echo;
+            TestScript script(input, slash == string::npos ? "" : job.file.substr(0, slash), computer);
+
+            script.setProgramCache(&cache);
+            script.setEcho(echo);
+
+            try
+            {
+                script.run();
+            }
+            catch(runtime_error &e)
+            {
+                throw runtime_error("(" + to_string(script.getLineNumber()) + "): " + e.what());
+            }
+        }
+        else
+        {
+            computer.load(cache.get(job.file));
+
+            for(auto &assignment : job.set)
+                computer.poke(assignment.first, assignment.second);
+
+            computer.run(job.cycles);
+        }
+    }
+    catch(exception &e)
+    {
+        result.passed = false;
+        result.error = e.what();
+    }
+
+    result.halted = computer.isHalted();
+    result.cycles = computer.getCycles();
+
+    check(job, result, [&](int address) { return computer.peek(address); });
+
+    return result;
+}
+
+void Batch::executeLockstep(const vector<size_t> &group)
+{
+    const Job &first = jobs[group[0]];
+
+    try
+    {
+        Lockstep lanes(cache.get(first.file), group.size());
+
+        for(size_t lane = 0; lane < group.size(); lane++)
+            for(auto &assignment : jobs[group[lane]].set)
+                lanes.poke(lane, assignment.first, assignment.second);
+
+        lanes.run(first.cycles);
+
+        for(size_t lane = 0; lane < group.size(); lane++)
+        {
+            Result &result = results[group[lane]];
+
+            result.passed = true;
+            result.halted = lanes.isHalted(lane);
+            result.cycles = lanes.getCycles(lane);
+
+            check(jobs[group[lane]], result, [&](int address) { return lanes.peek(lane, address); });
+        }
+    }
+    catch(exception &e)
+    {
+        for(size_t i : group)
+        {
+            results[i].passed = false;
+            results[i].halted = false;
+            results[i].cycles = 0;
+            results[i].error = e.what();
+        }
+    }
+}
+
+void Batch::check(const Job &job, Result &result, function<uint16_t(int)> peek)
+{
+    if(result.passed)
+        for(auto &expected : job.expect)
+            if(peek(expected.first) != expected.second)
+            {
+                result.passed = false;
+                result.error = "RAM[" + to_string(expected.first) + "] is " +
+                    to_string(static_cast<int16_t>(peek(expected.first))) + ", expected " +
+                    to_string(static_cast<int16_t>(expected.second));
+                break;
+            }
+
+    for(int address = job.dumpFrom; address <= job.dumpTo; address++)
+        result.ram.push_back(peek(address));
+}
+
+void Batch::run(int threads, bool lockstep, ostream &out)
+{
+    results.assign(jobs.size(), Result());
+
+    // a unit of work is one job, or a group of ROM jobs sharing lanes
+    vector<vector<size_t>> units;
+    map<pair<string, uint64_t>, size_t> open;
+
+    for(size_t i = 0; i < jobs.size(); i++)
+    {
+        if(!lockstep || jobs[i].script)
+        {
+            units.push_back(vector<size_t>(1, i));
+            continue;
+        }
+
+        auto key = make_pair(jobs[i].file, jobs[i].cycles);
+        auto group = open.find(key);
+
+        if(group == open.end() || units[group->second].size() == LANES)
+        {
+            open[key] = units.size();
+            units.push_back(vector<size_t>());
+        }
+
+        units[open[key]].push_back(i);
+    }
+
+    // units are all known up front, so idle workers simply claim the next
+    // unstarted one; no worker waits while there is work left
+    atomic<size_t> next{0};
+    vector<thread> workers;
+
+    auto work = [&]()
+    {
+        for(size_t i = next++; i < units.size(); i = next++)
+        {
+            if(lockstep && !jobs[units[i][0]].script)
+                executeLockstep(units[i]);
+            else
+                results[units[i][0]] = execute(jobs[units[i][0]]);
+        }
+    };
+
+    for(int i = 1; i < threads; i++)
+        workers.push_back(thread(work));
+
+    work();
+
+    for(auto &worker : workers)
+        worker.join();
+
+    failures = 0;
+    for(auto &result : results)
+        if(!result.passed)
+            failures++;
+
+    write(out);
+}
+
+static string quote(const string &text)
+{
+    string quoted = "\"";
+
+    for(char ch : text)
+    {
+        if(ch == '"' || ch == '\\')
+            quoted += string("\\") + ch;
+        else if(ch == '\n')
+            quoted += "\\n";
+        else if(static_cast<unsigned char>(ch) < 0x20)
+            quoted += " ";
+        else
+            quoted += ch;
+    }
+
+    return quoted + "\"";
+}
+
+void Batch::write(ostream &out)
+{
+    out << "[" << endl;
+
+    for(size_t i = 0; i < jobs.size(); i++)
+    {
+        const Job &job = jobs[i];
+        const Result &result = results[i];
+
+        out << "  {\"job\": " << quote(job.file)
+            << ", \"line\": " << job.line
+            << ", \"passed\": " << (result.passed ? "true" : "false")
+            << ", \"halted\": " << (result.halted ? "true" : "false")
+            << ", \"cycles\": " << result.cycles;
+
+        if(!result.ram.empty())
+        {
+            out << ", \"ram\": {\"from\": " << job.dumpFrom << ", \"values\": [";
+            for(size_t j = 0; j < result.ram.size(); j++)
+                out << (j ? ", " : "") << static_cast<int16_t>(result.ram[j]);
+            out << "]}";
+        }
+
+        if(!result.error.empty())
+            out << ", \"error\": " << quote(result.error);
+
+        out << "}" << (i + 1 < jobs.size() ? "," : "") << endl;
+    }
+
+    out << "]" << endl;
+}
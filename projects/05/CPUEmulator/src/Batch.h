@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Batch module.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "ProgramCache.h"
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Runs the jobs of a manifest on a pool of threads and reports the results as JSON.
+//
+// Each manifest line is one job, either a test script:
+//     FibonacciElement/FibonacciElement.tst [dump=<from>-<to>]
+// or a ROM with its initial RAM and expected results:
+//     Mult.asm set=0:6,1:7 expect=2:42 [cycles=<n>] [dump=<from>-<to>]
+// Blank lines and // comments are ignored; relative paths are taken from the
+// directory of the manifest. In lockstep mode ROM jobs on the same file and
+// cycle budget run together, LANES at a time, on the Lockstep engine.
+class Batch
+{
+public:
+    Batch(std::istream &manifest, const std::string &directory, bool haltDetection);
+
+    // runs every job on the given number of threads and writes one JSON array
+    void run(int threads, bool lockstep, std::ostream &out);
+    int getFailures();
+
+private:
+    struct Job
+    {
+        int line;
+        std::string file;
+        bool script;
+        std::vector<std::pair<int, uint16_t>> set;
+        std::vector<std::pair<int, uint16_t>> expect;
+        uint64_t cycles;
+        int dumpFrom;
+        int dumpTo;
+    };
+
+    struct Result
+    {
+        bool passed;
+        bool halted;
+        uint64_t cycles;
+        std::vector<uint16_t> ram;
+        std::string error;
+    };
+
+    std::vector<Job> jobs;
+    std::vector<Result> results;
+    ProgramCache cache;
+    bool haltDetection;
+    int failures;
+
+    void parse(std::istream &manifest, const std::string &directory);
+    Result execute(const Job &job);
+    void executeLockstep(const std::vector<size_t> &group);
+    void check(const Job &job, Result &result, std::function<uint16_t(int)> peek);
+    void write(std::ostream &out);
+};
+
+#endif // BATCH_H
@@ -0,0 +1,566 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Computer module.
+ */
+
+#include "Computer.h"
+#include "Heatmap.h"
+#include "Profiler.h"
+#include "Screen.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+const uint16_t ADDRESS_MASK{0x7FFF};
+
+// Idle loops longer than this are run rather than skipped
+const uint64_t IDLE_LOOP{64};
+
+// Cycles between two checks for an idle loop when fast-forwarding
+const uint64_t IDLE_CHECK{16384};
+
+Computer::Computer() : memory(new uint16_t[RAM_SIZE](), default_delete<uint16_t[]>()), ram{memory.get()}, a{0}, d{0}, pc{0}, cycles{0}, haltDetection{true}, fastForward{false}, trace{nullptr}, profiler{nullptr}, screen{nullptr}, heatmap{nullptr},
+    breakpoints(ROM_SIZE), watchpoints(RAM_SIZE), breakpointCount{0}, watchpointCount{0}, cycleLimit{0}, stop{Stop::NONE}, stopAddress{0}
+{
+    load(vector<uint16_t>());
+}
+
+void Computer::load(const vector<uint16_t> &program)
+{
+    load(decode(program, haltDetection));
+}
+
+void Computer::load(shared_ptr<const Program> program)
+{
+    this->program = program;
+    rom = program->data();
+
+    reset();
+}
+
+void Computer::reset()
+{
+    a = 0;
+    d = 0;
+    pc = 0;
+    cycles = 0;
+}
+
+Instruction Computer::decode(uint16_t word)
+{
+    Instruction ins;
+
+    ins.word = word;
+    ins.address = (word & 0x8000) == 0;
+    ins.useM = !ins.address && (word & 0x1000);
+    ins.alu = ins.address ? 0 : (word >> 6) & 0x3F;
+    ins.dest = ins.address ? 0 : (word >> 3) & 0x7;
+    ins.jump = ins.address ? 0 : word & 0x7;
+    ins.halt = false;
+
+    return ins;
+}
+
+// An instruction that can neither change state nor leave the straight line
+static bool inert(const Instruction &ins)
+{
+    return ins.address || (ins.dest == 0 && ins.jump == 0);
+}
+
+// Whether a C-instruction always jumps without writing anything
+static bool alwaysJumps(const Instruction &ins)
+{
+    if(ins.address || ins.dest != 0 || ins.jump == 0)
+        return false;
+
+    // constant computations (0, 1, -1) ignore both operands
+    bool constant = (ins.alu & ZX) && (ins.alu & ZY);
+
+    return ins.jump == 7 || (constant && jumps(ins.jump, compute(ins.alu, 0, 0)));
+}
+
+// Flags the instructions of idle loops as halts
+static void markHalts(Program &rom)
+{
+    // find loops @t ... 0;JMP back to t whose every instruction is inert; once
+    // entered anywhere up to the @t such a loop repeats forever without
+    // changing RAM or D
+    for(int j = 1; j < ROM_SIZE; j++)
+    {
+        if(!alwaysJumps(rom[j]))
+            continue;
+
+        int p = j - 1;
+        while(p >= 0 && !rom[p].address && inert(rom[p]))
+            p--;
+
+        if(p < 0)
+            continue;
+
+        int target = rom[p].word;
+
+        if(target > p)
+            continue;
+
+        bool idle = true;
+        for(int i = target; idle && i < j; i++)
+            idle = inert(rom[i]);
+
+        if(idle)
+            for(int i = target; i <= p; i++)
+                rom[i].halt = true;
+    }
+}
+
+shared_ptr<const Program> Computer::decode(const vector<uint16_t> &program, bool haltDetection)
+{
+    if(program.size() > ROM_SIZE)
+        throw runtime_error("Program of " + to_string(program.size()) + " instructions does not fit in ROM");
+
+    shared_ptr<Program> rom = make_shared<Program>(ROM_SIZE, decode(0));
+
+    for(size_t i = 0; i < program.size(); i++)
+        (*rom)[i] = decode(program[i]);
+
+    if(haltDetection)
+        markHalts(*rom);
+
+    return rom;
+}
+
+inline void Computer::execute(const Instruction &ins)
+{
+    if(ins.address)
+    {
+        a = ins.word;
+        pc = (pc + 1) & ADDRESS_MASK;
+    }
+    else
+    {
+        uint16_t address = a & ADDRESS_MASK;
+        uint16_t out = compute(ins.alu, d, ins.useM ? ram[address] : a);
+
+        // M is written through the old value of A, and the jump targets it too
+        if(ins.dest & 1)
+            ram[address] = out;
+        if(ins.dest & 2)
+            d = out;
+        if(ins.dest & 4)
+            a = out;
+
+        pc = jumps(ins.jump, out) ? address : (pc + 1) & ADDRESS_MASK;
+    }
+
+    cycles++;
+}
+
+void Computer::step()
+{
+    if(features() || !monitors.empty() || cycleLimit)
+        run(1);
+    else if(!rom[pc].halt)
+        execute(rom[pc]);
+}
+
+void Computer::run(uint64_t count)
+{
+    stop = Stop::NONE;
+
+    if(cycleLimit)
+    {
+        uint64_t left = cycleLimit > cycles ? cycleLimit - cycles : 0;
+
+        if(count >= left)
+        {
+            count = left;
+            stop = Stop::LIMIT;
+        }
+    }
+
+    // monitors are called between runs of the other loops, which never see them
+    if(!monitors.empty() || fastForward)
+    {
+        // skipped turns would go past breakpoints and watchpoints unseen
+        bool skipping = fastForward && !breakpointCount && !watchpointCount;
+
+        while(count > 0)
+        {
+            uint64_t slice = count;
+            for(Monitor *monitor : monitors)
+                slice = min(slice, monitor->due());
+
+            uint64_t start = cycles;
+
+            // whole turns of an idle loop leave the machine as they found it,
+            // so it only wakes when a monitor falls due; a busy one is checked
+            // again every IDLE_CHECK cycles
+            uint64_t period = skipping ? getIdlePeriod() : 0;
+            if(period > 0)
+                cycles += slice / period * period;
+            else if(skipping)
+                slice = min(slice, IDLE_CHECK);
+
+            runUnmonitored(slice - (cycles - start));
+
+            for(Monitor *monitor : monitors)
+                monitor->advance(cycles - start, *this);
+
+            if(cycles - start < slice)
+                break;
+
+            count -= slice;
+        }
+        return;
+    }
+
+    runUnmonitored(count);
+}
+
+unsigned Computer::features()
+{
+    return (trace ? TRACING : 0u) | (profiler ? PROFILING : 0u) | (screen ? SCREEN_TRACKING : 0u) |
+        (breakpointCount ? BREAKPOINTS : 0u) | (watchpointCount ? WATCHPOINTS : 0u) | (heatmap ? MEMORY_COUNTING : 0u);
+}
+
+void Computer::runUnmonitored(uint64_t count)
+{
+    (this->*runLoops[features()])(count);
+}
+
+// The run loop, built once for every set of features so that each run only
+// pays for the ones in use; runLoop<0> checks nothing but halts
+template <unsigned FEATURES>
+void Computer::runLoop(uint64_t count)
+{
+    while(count > 0)
+    {
+        // profiles and heatmaps are kept in chunks whose counts fit their counters
+        uint64_t chunk = (FEATURES & (PROFILING | MEMORY_COUNTING)) && count > PROFILE_CHUNK ? PROFILE_CHUNK : count;
+        uint64_t i = 0;
+
+        if(FEATURES & PROFILING)
+            profiler->enter(pc);
+
+        for(; i < chunk; i++)
+        {
+            const Instruction &ins = rom[pc];
+
+            if(ins.halt)
+            {
+                stop = Stop::HALT;
+                break;
+            }
+
+            uint16_t at = pc;
+            uint16_t address = a & ADDRESS_MASK;
+            bool write = !ins.address && (ins.dest & 1);
+
+            execute(ins);
+
+            if(FEATURES & PROFILING)
+                profiler->record(at, pc);
+
+            if(FEATURES & MEMORY_COUNTING)
+            {
+                if(ins.useM)
+                    heatmap->read(address);
+                if(write)
+                    heatmap->write(address);
+            }
+
+            if((FEATURES & SCREEN_TRACKING) && write)
+                screen->touch(address);
+
+            if(FEATURES & TRACING)
+                trace->record(at, a, d, write, address, write ? ram[address] : 0);
+
+            if((FEATURES & WATCHPOINTS) && write && watchpoints[address])
+            {
+                stop = Stop::WATCHPOINT;
+                stopAddress = address;
+                i++;
+                break;
+            }
+
+            if((FEATURES & BREAKPOINTS) && breakpoints[pc])
+            {
+                stop = Stop::BREAKPOINT;
+                stopAddress = pc;
+                i++;
+                break;
+            }
+        }
+
+        if(FEATURES & PROFILING)
+            profiler->leave(pc, i);
+
+        if(FEATURES & MEMORY_COUNTING)
+            heatmap->leave(i);
+
+        if(i < chunk)
+            break;
+
+        count -= chunk;
+    }
+}
+
+#define RUN_LOOPS_4(f) &Computer::runLoop<f>, &Computer::runLoop<f + 1>, &Computer::runLoop<f + 2>, &Computer::runLoop<f + 3>
+
+#define RUN_LOOPS_16(f) RUN_LOOPS_4(f), RUN_LOOPS_4(f + 4), RUN_LOOPS_4(f + 8), RUN_LOOPS_4(f + 12)
+
+const Computer::RunLoop Computer::runLoops[FEATURE_SETS] = {
+    RUN_LOOPS_16(0), RUN_LOOPS_16(16), RUN_LOOPS_16(32), RUN_LOOPS_16(48)
+};
+
+#undef RUN_LOOPS_16
+
+#undef RUN_LOOPS_4
+
+uint64_t Computer::getIdlePeriod()
+{
+    uint16_t probeA = a, probeD = d, probePC = pc;
+
+    // the words a turn writes are kept aside, so RAM itself is left alone
+    uint16_t written[IDLE_LOOP], values[IDLE_LOOP];
+    uint64_t writes = 0;
+
+    // once the registers and every word written come back round to what they
+    // are now, the program will go round the same way forever
+    for(uint64_t period = 1; period <= IDLE_LOOP; period++)
+    {
+        const Instruction &ins = rom[probePC];
+
+        if(ins.halt)
+            return 0;
+
+        if(ins.address)
+        {
+            probeA = ins.word;
+            probePC = (probePC + 1) & ADDRESS_MASK;
+        }
+        else
+        {
+            uint16_t address = probeA & ADDRESS_MASK;
+            uint64_t slot = 0;
+            while(slot < writes && written[slot] != address)
+                slot++;
+
+            uint16_t m = slot < writes ? values[slot] : ram[address];
+            uint16_t out = compute(ins.alu, probeD, ins.useM ? m : probeA);
+
+            if(ins.dest & 1)
+            {
+                written[slot] = address;
+                values[slot] = out;
+                writes = max(writes, slot + 1);
+            }
+            if(ins.dest & 2)
+                probeD = out;
+            if(ins.dest & 4)
+                probeA = out;
+
+            probePC = jumps(ins.jump, out) ? address : (probePC + 1) & ADDRESS_MASK;
+        }
+
+        if(probeA == a && probeD == d && probePC == pc)
+        {
+            bool same = true;
+            for(uint64_t i = 0; same && i < writes; i++)
+                same = values[i] == ram[written[i]];
+
+            if(same)
+                return period;
+        }
+    }
+
+    return 0;
+}
+
+bool Computer::isHalted()
+{
+    return rom[pc].halt;
+}
+
+void Computer::setHaltDetection(bool enabled)
+{
+    haltDetection = enabled;
+}
+
+void Computer::setTrace(TraceWriter *trace)
+{
+    this->trace = trace;
+}
+
+void Computer::setProfiler(Profiler *profiler)
+{
+    this->profiler = profiler;
+}
+
+void Computer::setScreen(Screen *screen)
+{
+    this->screen = screen;
+
+    if(screen)
+        screen->touchAll();
+}
+
+void Computer::setBreakpoint(int address, bool enabled)
+{
+    if(address < 0 || address >= ROM_SIZE)
+        throw runtime_error("ROM address " + to_string(address) + " out of range");
+
+    if(breakpoints[address] != enabled)
+        breakpointCount += enabled ? 1 : -1;
+
+    breakpoints[address] = enabled;
+}
+
+void Computer::setWatchpoint(int address, bool enabled)
+{
+    if(address < 0 || address >= RAM_SIZE)
+        throw runtime_error("RAM address " + to_string(address) + " out of range");
+
+    if(watchpoints[address] != enabled)
+        watchpointCount += enabled ? 1 : -1;
+
+    watchpoints[address] = enabled;
+}
+
+void Computer::setCycleLimit(uint64_t limit)
+{
+    cycleLimit = limit;
+}
+
+Stop Computer::getStop()
+{
+    return stop;
+}
+
+int Computer::getStopAddress()
+{
+    return stopAddress;
+}
+
+void Computer::setFastForward(bool enabled)
+{
+    fastForward = enabled;
+}
+
+void Computer::setHeatmap(Heatmap *heatmap)
+{
+    this->heatmap = heatmap;
+}
+
+void Computer::addMonitor(Monitor *monitor)
+{
+    monitors.push_back(monitor);
+}
+
+void Computer::removeMonitor(Monitor *monitor)
+{
+    monitors.erase(remove(monitors.begin(), monitors.end(), monitor), monitors.end());
+}
+
+uint16_t Computer::peek(int address)
+{
+    if(address < 0 || address >= RAM_SIZE)
+        throw runtime_error("RAM address " + to_string(address) + " out of range");
+
+    return ram[address];
+}
+
+void Computer::poke(int address, uint16_t value)
+{
+    if(address < 0 || address >= RAM_SIZE)
+        throw runtime_error("RAM address " + to_string(address) + " out of range");
+
+    ram[address] = value;
+
+    if(screen)
+        screen->touch(address);
+}
+
+void Computer::setRAM(shared_ptr<uint16_t> memory)
+{
+    this->memory = memory;
+    ram = this->memory.get();
+
+    if(screen)
+        screen->touchAll();
+}
+
+const uint16_t *Computer::getRAM()
+{
+    return ram;
+}
+
+shared_ptr<const Program> Computer::getProgram()
+{
+    return program;
+}
+
+uint16_t Computer::getA()
+{
+    return a;
+}
+
+uint16_t Computer::getD()
+{
+    return d;
+}
+
+uint16_t Computer::getPC()
+{
+    return pc;
+}
+
+void Computer::setA(uint16_t value)
+{
+    a = value;
+}
+
+void Computer::setD(uint16_t value)
+{
+    d = value;
+}
+
+void Computer::setPC(uint16_t value)
+{
+    pc = value & ADDRESS_MASK;
+}
+
+uint64_t Computer::getCycles()
+{
+    return cycles;
+}
+
+void Computer::setCycles(uint64_t value)
+{
+    cycles = value;
+}
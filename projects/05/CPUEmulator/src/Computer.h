@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Computer module.
+ */
+
+#ifndef COMPUTER_H
+#define COMPUTER_H
+
+#include "Trace.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Computer;
+class Heatmap;
+class Profiler;
+class Screen;
+
+const int ROM_SIZE{32768};
+const int RAM_SIZE{32768};
+const int SCREEN_ADDRESS{16384};
+const int KBD_ADDRESS{24576};
+
+// ALU control bits of a C-instruction, as laid out in chapter 2
+enum ALUBits : uint8_t
+{
+    NO = 0x01,
+    F  = 0x02,
+    NY = 0x04,
+    ZY = 0x08,
+    NX = 0x10,
+    ZX = 0x20
+};
+
+// A machine word decoded once at load time so the run loop never has to
+struct Instruction
+{
+    uint16_t word;
+    bool address;
+    bool useM;
+    uint8_t alu;
+    uint8_t dest;
+    uint8_t jump;
+    bool halt;
+};
+
+// A decoded ROM image. It is never modified once built, so any number of
+// computers running the same program can share one
+typedef std::vector<Instruction> Program;
+
+// Something the emulator calls back every so many cycles, between two instructions
+class Monitor
+{
+public:
+    virtual ~Monitor() {}
+
+    // the cycles left until it next needs to be called
+    virtual uint64_t due() = 0;
+
+    // called after the emulator ran the given number of cycles
+    virtual void advance(uint64_t cycles, Computer &computer) = 0;
+};
+
+// Why the last run ended before the cycles it was given
+enum class Stop
+{
+    NONE,
+    HALT,
+    BREAKPOINT,
+    WATCHPOINT,
+    LIMIT
+};
+
+// The Hack computer of chapter 5: ROM, RAM and the A, D and PC registers
+class Computer
+{
+public:
+    Computer();
+
+    // loads a program into ROM and resets the CPU; RAM is left untouched
+    void load(const std::vector<uint16_t> &program);
+    void load(std::shared_ptr<const Program> program);
+    void reset();
+
+    // executes one instruction, or the given number of instructions; both stop once halted
+    void step();
+    void run(uint64_t cycles);
+
+    // a program has halted when it reaches an idle loop such as (END) @END 0;JMP;
+    // the setting applies to programs loaded after it
+    bool isHalted();
+    void setHaltDetection(bool enabled);
+
+    // instruments every run from now on; nullptr turns the instrument off again
+    void setTrace(TraceWriter *trace);
+    void setProfiler(Profiler *profiler);
+    void setScreen(Screen *screen);
+    void setHeatmap(Heatmap *heatmap);
+    void addMonitor(Monitor *monitor);
+    void removeMonitor(Monitor *monitor);
+
+    // breakpoints stop a run when it arrives at a ROM address, watchpoints
+    // right after an instruction writes a RAM address, and the cycle limit
+    // once the computer has run that many cycles in all (0 for none)
+    void setBreakpoint(int address, bool enabled);
+    void setWatchpoint(int address, bool enabled);
+    void setCycleLimit(uint64_t limit);
+
+    // why the last run stopped early, and the ROM or RAM address of the
+    // breakpoint or watchpoint that stopped it
+    Stop getStop();
+    int getStopAddress();
+
+    // skips ahead through loops that wait for RAM to change, such as polls of
+    // the keyboard, instead of running them; the cycles skipped are neither
+    // traced nor profiled
+    void setFastForward(bool enabled);
+
+    // the length of the loop the program is caught in when a turn of it leaves
+    // registers and RAM as they were, so that only a change from outside, such
+    // as a key press, can move it on; 0 when it is not idle or has halted
+    uint64_t getIdlePeriod();
+
+    uint16_t peek(int address);
+    void poke(int address, uint16_t value);
+
+    // replaces RAM with the given RAM_SIZE words, such as a copy-on-write mapping of a snapshot
+    void setRAM(std::shared_ptr<uint16_t> memory);
+
+    // RAM as one array of RAM_SIZE words, valid until the next setRAM
+    const uint16_t *getRAM();
+    std::shared_ptr<const Program> getProgram();
+
+    uint16_t getA();
+    uint16_t getD();
+    uint16_t getPC();
+    void setA(uint16_t value);
+    void setD(uint16_t value);
+    void setPC(uint16_t value);
+    uint64_t getCycles();
+    void setCycles(uint64_t value);
+
+    static Instruction decode(uint16_t word);
+    static std::shared_ptr<const Program> decode(const std::vector<uint16_t> &program, bool haltDetection);
+
+private:
+    std::shared_ptr<const Program> program;
+    const Instruction *rom;
+    std::shared_ptr<uint16_t> memory;
+    uint16_t *ram;
+    uint16_t a;
+    uint16_t d;
+    uint16_t pc;
+    uint64_t cycles;
+    bool haltDetection;
+    bool fastForward;
+    TraceWriter *trace;
+    Profiler *profiler;
+    Screen *screen;
+    Heatmap *heatmap;
+    std::vector<Monitor *> monitors;
+    std::vector<bool> breakpoints;
+    std::vector<bool> watchpoints;
+    int breakpointCount;
+    int watchpointCount;
+    uint64_t cycleLimit;
+    Stop stop;
+    int stopAddress;
+
+    // the optional features of the run loop, each compiled in or out of it
+    enum Feature : unsigned
+    {
+        TRACING = 1,
+        PROFILING = 2,
+        SCREEN_TRACKING = 4,
+        BREAKPOINTS = 8,
+        WATCHPOINTS = 16,
+        MEMORY_COUNTING = 32,
+        FEATURE_SETS = 64
+    };
+
+    typedef void (Computer::*RunLoop)(uint64_t count);
+    static const RunLoop runLoops[FEATURE_SETS];
+
+    inline void execute(const Instruction &ins);
+    unsigned features();
+    void runUnmonitored(uint64_t count);
+    template <unsigned FEATURES> void runLoop(uint64_t count);
+};
+
+// Computes the ALU output for the given control bits, as the hardware of chapter 2 does
+inline uint16_t compute(uint8_t bits, uint16_t x, uint16_t y)
+{
+    if(bits & ZX) x = 0;
+    if(bits & NX) x = ~x;
+    if(bits & ZY) y = 0;
+    if(bits & NY) y = ~y;
+
+    uint16_t out = (bits & F) ? static_cast<uint16_t>(x + y) : static_cast<uint16_t>(x & y);
+
+    if(bits & NO) out = ~out;
+
+    return out;
+}
+
+// Whether the jump bits of a C-instruction are satisfied by the ALU output
+inline bool jumps(uint8_t jump, uint16_t out)
+{
+    int16_t value = static_cast<int16_t>(out);
+
+    return ((jump & 4) && value < 0) || ((jump & 2) && value == 0) || ((jump & 1) && value > 0);
+}
+
+#endif // COMPUTER_H
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Display module.
+ */
+
+#include "Display.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+// Cycles between two looks at the clock; a small fraction of a frame at any
+// speed the emulator runs at
+const uint64_t DISPLAY_CHECK{1u << 14};
+
+Display::Display(int framesPerSecond) :
+    back{0}, front{1}, middle{2}, countdown{DISPLAY_CHECK}, published{0}, rendered{0}, done{false}
+{
+    if(framesPerSecond <= 0)
+        throw runtime_error("The frame rate must be at least one frame per second");
+
+    period = chrono::duration_cast<chrono::steady_clock::duration>(chrono::seconds(1)) / framesPerSecond;
+
+    for(Snapshot &snapshot : buffers)
+    {
+        memset(snapshot.words, 0, sizeof(snapshot.words));
+        snapshot.cycle = 0;
+    }
+}
+
+Display::~Display()
+{
+    stop();
+}
+
+uint64_t Display::due()
+{
+    return countdown;
+}
+
+void Display::advance(uint64_t cycles, Computer &computer)
+{
+    countdown -= min(cycles, countdown);
+
+    if(countdown > 0)
+        return;
+
+    countdown = DISPLAY_CHECK;
+
+    // the renderer starts with the first frame, once any subclass is fully built
+    if(!renderer.joinable())
+    {
+        nextFrame = chrono::steady_clock::now();
+        renderer = thread(&Display::render, this);
+    }
+
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if(now < nextFrame)
+        return;
+
+    publish(computer);
+
+    // a run held up elsewhere starts a fresh frame period rather than catching up
+    nextFrame += period;
+    if(nextFrame < now)
+        nextFrame = now + period;
+}
+
+void Display::close(Computer &computer)
+{
+    if(!renderer.joinable())
+        renderer = thread(&Display::render, this);
+
+    publish(computer);
+    stop();
+}
+
+Screen &Display::getFramebuffer()
+{
+    return framebuffer;
+}
+
+int Display::getPublished()
+{
+    return published.load(memory_order_relaxed);
+}
+
+int Display::getRendered()
+{
+    return rendered.load(memory_order_relaxed);
+}
+
+void Display::present(Screen &, uint64_t)
+{
+}
+
+void Display::publish(Computer &computer)
+{
+    Snapshot &snapshot = buffers[back];
+    memcpy(snapshot.words, computer.getRAM() + SCREEN_ADDRESS, sizeof(snapshot.words));
+    snapshot.cycle = computer.getCycles();
+
+    // release the words to whoever takes the middle buffer next
+    back = middle.exchange(back | FRESH, memory_order_acq_rel) & ~FRESH;
+    published.fetch_add(1, memory_order_relaxed);
+}
+
+bool Display::take()
+{
+    if(!(middle.load(memory_order_relaxed) & FRESH))
+        return false;
+
+    front = middle.exchange(front, memory_order_acq_rel) & ~FRESH;
+    return true;
+}
+
+void Display::stop()
+{
+    if(!renderer.joinable())
+        return;
+
+    done.store(true, memory_order_release);
+    renderer.join();
+}
+
+void Display::render()
+{
+    // poll a few times a frame, so a new one waits a fraction of a period at most
+    chrono::steady_clock::duration poll = period / 4;
+
+    for(;;)
+    {
+        // read done first, so a frame published before it was set cannot be missed
+        bool finished = done.load(memory_order_acquire);
+
+        if(take())
+        {
+            Snapshot &snapshot = buffers[front];
+
+            // the snapshot holds no dirty rows, but unchanged ones are only compared
+            framebuffer.touchAll();
+            if(framebuffer.update(snapshot.words))
+                present(framebuffer, snapshot.cycle);
+
+            rendered.fetch_add(1, memory_order_relaxed);
+        }
+        else if(finished)
+            break;
+        else
+            this_thread::sleep_for(poll);
+    }
+}
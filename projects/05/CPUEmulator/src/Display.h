@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Display module.
+ */
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include "Computer.h"
+#include "Screen.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+// Shows the screen of a running computer at a fixed frame rate, on a thread
+// of its own.
+//
+// Every so many cycles the emulator checks the clock, and once a frame is due
+// copies the screen words into a snapshot. Snapshots go through a triple
+// buffer: the emulator fills its back buffer and swaps it with the middle one,
+// and the renderer swaps the middle one with its front buffer when it holds a
+// newer frame. Both swaps are a single atomic exchange, so the emulator never
+// waits on the renderer, however slow it is; frames it cannot keep up with are
+// dropped. The renderer unpacks each new snapshot into a headless framebuffer
+// and hands it to present().
+class Display : public Monitor
+{
+public:
+    Display(int framesPerSecond);
+    virtual ~Display();
+
+    uint64_t due() override;
+    void advance(uint64_t cycles, Computer &computer) override;
+
+    // publishes the screen as the run left it and waits for the renderer to
+    // show it and stop
+    void close(Computer &computer);
+
+    // the pixels of the last frame shown; only to be looked at once closed,
+    // or from present()
+    Screen &getFramebuffer();
+
+    // the frames the emulator published and the renderer showed
+    int getPublished();
+    int getRendered();
+
+    Display(const Display &) = delete;
+    Display &operator=(const Display &) = delete;
+
+protected:
+    // called on the renderer thread with each frame that changed the
+    // framebuffer; a windowed front end would draw it here. A subclass that
+    // overrides it closes the display in its own destructor.
+    virtual void present(Screen &framebuffer, uint64_t cycle);
+
+private:
+    struct Snapshot
+    {
+        uint16_t words[SCREEN_WORDS];
+        uint64_t cycle;
+    };
+
+    // set in the middle index when it holds a frame the renderer has not taken
+    static const unsigned FRESH{4};
+
+    Snapshot buffers[3];
+    unsigned back;
+    unsigned front;
+    std::atomic<unsigned> middle;
+
+    std::chrono::steady_clock::duration period;
+    std::chrono::steady_clock::time_point nextFrame;
+    uint64_t countdown;
+
+    Screen framebuffer;
+    std::atomic<int> published;
+    std::atomic<int> rendered;
+    std::atomic<bool> done;
+    std::thread renderer;
+
+    void publish(Computer &computer);
+    bool take();
+    void render();
+    void stop();
+};
+
+#endif // DISPLAY_H
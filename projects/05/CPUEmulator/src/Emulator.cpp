@@ -0,0 +1,416 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Entry point and facade controller of the emulator
+ */
+#include "Emulator.h"
+#include "Batch.h"
+#include "Computer.h"
+#include "Display.h"
+#include "Heatmap.h"
+#include "Keyboard.h"
+#include "Loader.h"
+#include "Profiler.h"
+#include "Screen.h"
+#include "StackSampler.h"
+#include "TestScript.h"
+#include "Trace.h"
+
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+// addresses listed for each function in a profile
+const int PROFILE_TOP{10};
+
+// cycles between two samples of the call stack, unless given
+const uint64_t DEFAULT_INTERVAL{1000};
+
+// cycles between two captures of the screen, unless given
+const uint64_t DEFAULT_FRAME_INTERVAL{100000};
+
+const string USAGE{"Usage: CPUEmulator [--no-halt] [--trace <file>] [--profile <name> [--jumps]]\n"
+                   "                   [--sample <name> [--interval <cycles>]]\n"
+                   "                   [--frames <prefix> [--frame-interval <cycles>] [--ppm] [--diff]]\n"
+                   "                   [--keys <file>] [--fast-forward] [--display <frames per second>]\n"
+                   "                   [--break <rom address>]... [--watch <ram address>]... [--max-cycles <n>]\n"
+                   "                   [--heatmap <name>] <script.tst>\n"
+                   "       CPUEmulator [--no-halt] [--threads <n>] [--lockstep] --batch <manifest>\n"
+                   "       CPUEmulator [--csv] --read-trace <file>"};
+
+Emulator::Emulator(const vector<string> &arguments) : haltDetection{true}, batch{false}, lockstep{false}, readTrace{false}, csv{false}, jumps{false}, interval{DEFAULT_INTERVAL}, frameInterval{DEFAULT_FRAME_INTERVAL}, ppm{false}, diff{false}, fastForward{false}, displayRate{0}, maxCycles{0}, threads{0}
+{
+    for(size_t i = 1; i < arguments.size(); i++)
+    {
+        if(arguments[i] == "--no-halt")
+            haltDetection = false;
+        else if(arguments[i] == "--batch")
+            batch = true;
+        else if(arguments[i] == "--lockstep")
+            lockstep = true;
+        else if(arguments[i] == "--read-trace")
+            readTrace = true;
+        else if(arguments[i] == "--csv")
+            csv = true;
+        else if(arguments[i] == "--trace" && i + 1 < arguments.size())
+            traceFile = arguments[++i];
+        else if(arguments[i] == "--profile" && i + 1 < arguments.size())
+            profileName = arguments[++i];
+        else if(arguments[i] == "--jumps")
+            jumps = true;
+        else if(arguments[i] == "--sample" && i + 1 < arguments.size())
+            sampleName = arguments[++i];
+        else if(arguments[i] == "--interval" && i + 1 < arguments.size())
+            interval = parseCycles(arguments[++i]);
+        else if(arguments[i] == "--frames" && i + 1 < arguments.size())
+            framePrefix = arguments[++i];
+        else if(arguments[i] == "--frame-interval" && i + 1 < arguments.size())
+            frameInterval = parseCycles(arguments[++i]);
+        else if(arguments[i] == "--ppm")
+            ppm = true;
+        else if(arguments[i] == "--diff")
+            diff = true;
+        else if(arguments[i] == "--keys" && i + 1 < arguments.size())
+            keyFile = arguments[++i];
+        else if(arguments[i] == "--fast-forward")
+            fastForward = true;
+        else if(arguments[i] == "--break" && i + 1 < arguments.size())
+            breakpoints.push_back(parseAddress(arguments[++i]));
+        else if(arguments[i] == "--watch" && i + 1 < arguments.size())
+            watchpoints.push_back(parseAddress(arguments[++i]));
+        else if(arguments[i] == "--max-cycles" && i + 1 < arguments.size())
+            maxCycles = parseCycles(arguments[++i]);
+        else if(arguments[i] == "--heatmap" && i + 1 < arguments.size())
+            heatmapName = arguments[++i];
+        else if(arguments[i] == "--threads" && i + 1 < arguments.size())
+        {
+            try
+            {
+                threads = stoi(arguments[++i]);
+            }
+            catch(logic_error &e)
+            {
+            }
+            if(threads <= 0)
+                throw runtime_error("'" + arguments[i] + "' is not a thread count");
+        }
+        else if(arguments[i] == "--display" && i + 1 < arguments.size())
+        {
+            try
+            {
+                displayRate = stoi(arguments[++i]);
+            }
+            catch(logic_error &e)
+            {
+            }
+            if(displayRate <= 0)
+                throw runtime_error("'" + arguments[i] + "' is not a frame rate");
+        }
+        else if(arguments[i].compare(0, 2, "--") == 0)
+            throw runtime_error("Unknown option '" + arguments[i] + "'. " + USAGE);
+        else if(scriptFile.empty())
+            scriptFile = arguments[i];
+        else
+            throw runtime_error(USAGE);
+    }
+    
+    if(scriptFile.empty())
+        throw runtime_error(USAGE);
+}
+
+uint64_t Emulator::parseCycles(const string &argument)
+{
+    uint64_t cycles = 0;
+
+    try
+    {
+        cycles = stoull(argument);
+    }
+    catch(logic_error &e)
+    {
+    }
+    if(cycles == 0)
+        throw runtime_error("'" + argument + "' is not a number of cycles");
+
+    return cycles;
+}
+
+int Emulator::parseAddress(const string &argument)
+{
+    int address = -1;
+
+    try
+    {
+        address = stoi(argument);
+    }
+    catch(logic_error &e)
+    {
+    }
+    if(address < 0 || address > 32767 || argument.find_first_not_of("0123456789") != string::npos)
+        throw runtime_error("'" + argument + "' is not an address");
+
+    return address;
+}
+
+void Emulator::run()
+{
+    ifstream input(scriptFile, readTrace ? ios::binary : ios::in);
+    
+    if(!input)
+        throw runtime_error("Could not open '" + scriptFile + "'");
+    
+    if(readTrace)
+    {
+        TraceReader reader(input);
+        printTrace(reader, cout, csv);
+        return;
+    }
+    
+    // files named by the script live next to it
+    size_t slash = scriptFile.find_last_of("/\\");
+    string directory = slash == string::npos ? "" : scriptFile.substr(0, slash);
+    
+    if(batch)
+    {
+        runBatch(input, directory);
+        return;
+    }
+    
+    Computer computer;
+    computer.setHaltDetection(haltDetection);
+    
+    unique_ptr<TraceWriter> trace;
+    if(!traceFile.empty())
+    {
+        trace.reset(new TraceWriter(traceFile));
+        computer.setTrace(trace.get());
+    }
+    
+    unique_ptr<Profiler> profiler;
+    if(!profileName.empty())
+    {
+        profiler.reset(new Profiler(jumps));
+        computer.setProfiler(profiler.get());
+    }
+    
+    unique_ptr<StackSampler> sampler;
+    if(!sampleName.empty())
+    {
+        sampler.reset(new StackSampler(interval));
+        computer.addMonitor(sampler.get());
+    }
+    
+    unique_ptr<Heatmap> heatmap;
+    if(!heatmapName.empty())
+    {
+        heatmap.reset(new Heatmap);
+        computer.setHeatmap(heatmap.get());
+    }
+    
+    unique_ptr<Screen> screen;
+    unique_ptr<FrameRecorder> recorder;
+    if(!framePrefix.empty())
+    {
+        screen.reset(new Screen);
+        recorder.reset(new FrameRecorder(*screen, framePrefix, frameInterval, ppm, diff));
+        computer.setScreen(screen.get());
+        computer.addMonitor(recorder.get());
+    }
+    
+    unique_ptr<Display> display;
+    if(displayRate > 0)
+    {
+        display.reset(new Display(displayRate));
+        computer.addMonitor(display.get());
+    }
+    
+    unique_ptr<KeyboardReplay> keyboard;
+    if(!keyFile.empty())
+    {
+        ifstream keys(keyFile);
+        if(!keys)
+            throw runtime_error("Could not open '" + keyFile + "'");
+        
+        try
+        {
+            keyboard.reset(new KeyboardReplay(keys));
+        }
+        catch(runtime_error &e)
+        {
+            throw runtime_error(keyFile + ": " + e.what());
+        }
+        computer.addMonitor(keyboard.get());
+    }
+    computer.setFastForward(fastForward);
+    computer.setCycleLimit(maxCycles);
+    
+    for(int address : breakpoints)
+        computer.setBreakpoint(address, true);
+    for(int address : watchpoints)
+        computer.setWatchpoint(address, true);
+    
+    TestScript script(input, directory, computer);
+    
+    try
+    {
+        script.run();
+    }
+    catch(runtime_error &e)
+    {
+        throw runtime_error(scriptFile + " (" + to_string(script.getLineNumber()) + "): " + e.what());
+    }
+    
+    if(trace)
+        trace->close();
+    
+    if(recorder)
+    {
+        recorder->finish(computer);
+        cout << recorder->getFrames() << " frames written to " << framePrefix << "_*" << (ppm ? ".ppm" : ".pbm") << endl;
+    }
+    
+    if(display)
+    {
+        display->close(computer);
+        cout << display->getRendered() << " of " << display->getPublished() << " frames displayed" << endl;
+    }
+    
+    if(heatmap)
+        writeHeatmap(*heatmap);
+    
+    if(profiler || sampler)
+    {
+        SourceMap map = Loader::loadMap(script.getProgramFile());
+        
+        if(profiler)
+            writeProfile(*profiler, map);
+        if(sampler)
+            writeSamples(*sampler, map);
+    }
+    
+    if(computer.isHalted())
+        cout << "Halted at ROM[" << computer.getPC() << "] after " << computer.getCycles() << " cycles" << endl;
+    else if(computer.getStop() == Stop::BREAKPOINT)
+        cout << "Breakpoint at ROM[" << computer.getStopAddress() << "] after " << computer.getCycles() << " cycles" << endl;
+    else if(computer.getStop() == Stop::WATCHPOINT)
+        cout << "Watchpoint on RAM[" << computer.getStopAddress() << "] at ROM[" << computer.getPC() << "] after " << computer.getCycles() << " cycles" << endl;
+    else if(computer.getStop() == Stop::LIMIT)
+        cout << "Stopped at ROM[" << computer.getPC() << "] after the limit of " << computer.getCycles() << " cycles" << endl;
+    
+    if(script.isInterrupted())
+        cout << "Script interrupted" << endl;
+    else if(script.hasComparison())
+        cout << "End of script - Comparison ended successfully" << endl;
+    else
+        cout << "End of script" << endl;
+}
+
+void Emulator::writeProfile(Profiler &profiler, const SourceMap &map)
+{
+    ofstream report(profileName + ".prof");
+    ofstream collapsed(profileName + ".folded");
+    
+    if(!report || !collapsed)
+        throw runtime_error("Could not write the profile '" + profileName + "'");
+    
+    profiler.report(report, map, PROFILE_TOP);
+    profiler.writeCollapsed(collapsed, map);
+    
+    cout << "Profile written to " << profileName << ".prof and " << profileName << ".folded" << endl;
+}
+
+void Emulator::writeHeatmap(Heatmap &heatmap)
+{
+    ofstream report(heatmapName + ".heat");
+    ofstream counts(heatmapName + ".csv");
+    
+    if(!report || !counts)
+        throw runtime_error("Could not write the heatmap '" + heatmapName + "'");
+    
+    heatmap.report(report);
+    heatmap.writeCSV(counts);
+    
+    cout << "Heatmap written to " << heatmapName << ".heat and " << heatmapName << ".csv" << endl;
+}
+
+void Emulator::writeSamples(StackSampler &sampler, const SourceMap &map)
+{
+    ofstream report(sampleName + ".calls");
+    ofstream collapsed(sampleName + ".stacks");
+    
+    if(!report || !collapsed)
+        throw runtime_error("Could not write the samples '" + sampleName + "'");
+    
+    sampler.report(report, map);
+    sampler.writeCollapsed(collapsed, map);
+    
+    cout << "Call stack samples written to " << sampleName << ".calls and " << sampleName << ".stacks" << endl;
+}
+
+void Emulator::runBatch(istream &manifest, const string &directory)
+{
+    Batch jobs(manifest, directory, haltDetection);
+    
+    int count = threads > 0 ? threads : thread::hardware_concurrency();
+    
+    jobs.run(count > 0 ? count : 1, lockstep, cout);
+    
+    if(jobs.getFailures() > 0)
+        throw runtime_error(to_string(jobs.getFailures()) + " job(s) failed");
+}
+
+int main(int argc, char *argv[])
+{
+    // collect arguments passed to the program
+    vector<string> arguments;
+    
+    for(int i = 0; i < argc; i++)
+    {
+        arguments.push_back(argv[i]);
+    }
+    
+    try
+    {
+        // pass them to the emulator
+        Emulator program(arguments);
+        program.run();
+    }
+    catch(exception &e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    catch(...)
+    {
+        cerr << "Unknown error!" << endl;
+        return 2;
+    }
+    
+    return 0;
+}
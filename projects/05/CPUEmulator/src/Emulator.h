@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the facade controller of the emulator
+ */
+
+#ifndef EMULATOR_H
+#define EMULATOR_H
+
+#include "Heatmap.h"
+#include "Profiler.h"
+#include "StackSampler.h"
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+class Emulator
+{
+public:
+    
+    // constructs the emulator by passing in command line arguments as configuration
+    Emulator(const std::vector<std::string> &arguments);
+    
+    // runs the test script, runs the jobs of a batch manifest, or prints a trace
+    void run();
+
+private:
+    
+    std::string scriptFile;
+    bool haltDetection;
+    bool batch;
+    bool lockstep;
+    bool readTrace;
+    bool csv;
+    std::string traceFile;
+    std::string profileName;
+    bool jumps;
+    std::string sampleName;
+    uint64_t interval;
+    std::string framePrefix;
+    uint64_t frameInterval;
+    bool ppm;
+    bool diff;
+    std::string keyFile;
+    bool fastForward;
+    int displayRate;
+    std::vector<int> breakpoints;
+    std::vector<int> watchpoints;
+    uint64_t maxCycles;
+    std::string heatmapName;
+    int threads;
+    
+    static uint64_t parseCycles(const std::string &argument);
+    static int parseAddress(const std::string &argument);
+    void runBatch(std::istream &manifest, const std::string &directory);
+    void writeProfile(Profiler &profiler, const SourceMap &map);
+    void writeHeatmap(Heatmap &heatmap);
+    void writeSamples(StackSampler &sampler, const SourceMap &map);
+};
+
+#endif // EMULATOR_H
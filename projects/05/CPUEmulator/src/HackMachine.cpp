@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the HackMachine module.
+ */
+
+#include "HackMachine.h"
+#include "Computer.h"
+#include "Loader.h"
+
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct hack_machine
+{
+    Computer computer;
+    string error;
+};
+
+// Keeps the message for hack_last_error, or none if even that runs out of memory
+static void fail(hack_machine *machine, const char *message)
+{
+    try
+    {
+        machine->error = message;
+    }
+    catch(...)
+    {
+        machine->error.clear();
+    }
+}
+
+// Runs an action on the machine, turning any exception into -1 and a message,
+// as none may cross into C
+template <typename Action>
+static int guard(hack_machine *machine, Action action)
+{
+    try
+    {
+        action();
+        return 0;
+    }
+    catch(exception &e)
+    {
+        fail(machine, e.what());
+    }
+    catch(...)
+    {
+        fail(machine, "Unknown error");
+    }
+
+    return -1;
+}
+
+static void checkRange(int address, size_t count)
+{
+    if(address < 0 || address > RAM_SIZE || count > static_cast<size_t>(RAM_SIZE - address))
+        throw runtime_error("RAM addresses " + to_string(address) + " to " + to_string(address + count) + " out of range");
+}
+
+int hack_version(void)
+{
+    return HACK_API_VERSION;
+}
+
+hack_machine *hack_create(void)
+{
+    // the computer allocates its RAM and run loops as it is built
+    try
+    {
+        return new hack_machine;
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+}
+
+void hack_destroy(hack_machine *machine)
+{
+    delete machine;
+}
+
+const char *hack_last_error(hack_machine *machine)
+{
+    return machine->error.c_str();
+}
+
+int hack_load_words(hack_machine *machine, const uint16_t *words, size_t count)
+{
+    return guard(machine, [&]() {
+        machine->computer.load(vector<uint16_t>(words, words + count));
+    });
+}
+
+int hack_load_hack(hack_machine *machine, const char *text, size_t length)
+{
+    return guard(machine, [&]() {
+        istringstream input(string(text, length));
+        machine->computer.load(Loader::readHack(input));
+    });
+}
+
+int hack_load_asm(hack_machine *machine, const char *source, size_t length)
+{
+    return guard(machine, [&]() {
+        istringstream input(string(source, length));
+        machine->computer.load(Loader::assemble(input));
+    });
+}
+
+void hack_reset(hack_machine *machine)
+{
+    machine->computer.reset();
+}
+
+int hack_clear_ram(hack_machine *machine)
+{
+    return guard(machine, [&]() {
+        machine->computer.setRAM(shared_ptr<uint16_t>(new uint16_t[RAM_SIZE](), default_delete<uint16_t[]>()));
+    });
+}
+
+hack_stop hack_run(hack_machine *machine, uint64_t cycles)
+{
+    if(guard(machine, [&]() { machine->computer.run(cycles); }) != 0)
+        return HACK_STOP_ERROR;
+
+    switch(machine->computer.getStop())
+    {
+        case Stop::HALT:
+            return HACK_STOP_HALT;
+        case Stop::BREAKPOINT:
+            return HACK_STOP_BREAKPOINT;
+        case Stop::WATCHPOINT:
+            return HACK_STOP_WATCHPOINT;
+        default:
+            return HACK_STOP_CYCLES;
+    }
+}
+
+int hack_set_breakpoint(hack_machine *machine, int address, int enabled)
+{
+    return guard(machine, [&]() {
+        machine->computer.setBreakpoint(address, enabled != 0);
+    });
+}
+
+int hack_set_watchpoint(hack_machine *machine, int address, int enabled)
+{
+    return guard(machine, [&]() {
+        machine->computer.setWatchpoint(address, enabled != 0);
+    });
+}
+
+int hack_stop_address(hack_machine *machine)
+{
+    return machine->computer.getStopAddress();
+}
+
+int hack_peek(hack_machine *machine, int address, uint16_t *value)
+{
+    return guard(machine, [&]() {
+        *value = machine->computer.peek(address);
+    });
+}
+
+int hack_poke(hack_machine *machine, int address, uint16_t value)
+{
+    return guard(machine, [&]() {
+        machine->computer.poke(address, value);
+    });
+}
+
+int hack_read_ram(hack_machine *machine, int address, uint16_t *words, size_t count)
+{
+    return guard(machine, [&]() {
+        checkRange(address, count);
+        memcpy(words, machine->computer.getRAM() + address, count * sizeof(uint16_t));
+    });
+}
+
+int hack_write_ram(hack_machine *machine, int address, const uint16_t *words, size_t count)
+{
+    return guard(machine, [&]() {
+        checkRange(address, count);
+
+        // through poke, so that the screen and keyboard see the words as they would any other
+        for(size_t i = 0; i < count; i++)
+            machine->computer.poke(address + static_cast<int>(i), words[i]);
+    });
+}
+
+uint16_t hack_get_a(hack_machine *machine)
+{
+    return machine->computer.getA();
+}
+
+uint16_t hack_get_d(hack_machine *machine)
+{
+    return machine->computer.getD();
+}
+
+uint16_t hack_get_pc(hack_machine *machine)
+{
+    return machine->computer.getPC();
+}
+
+uint64_t hack_get_cycles(hack_machine *machine)
+{
+    return machine->computer.getCycles();
+}
+
+int hack_is_halted(hack_machine *machine)
+{
+    return machine->computer.isHalted() ? 1 : 0;
+}
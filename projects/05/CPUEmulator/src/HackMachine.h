@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the HackMachine module: the C API of the emulator library.
+ */
+
+#ifndef HACK_MACHINE_H
+#define HACK_MACHINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(HACK_MACHINE_BUILD)
+#    define HACK_API __declspec(dllexport)
+#  else
+#    define HACK_API __declspec(dllimport)
+#  endif
+#else
+#  define HACK_API __attribute__((visibility("default")))
+#endif
+
+/* Bumped whenever a function changes; functions are only ever added otherwise */
+#define HACK_API_VERSION 2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A Hack computer: 32K words of ROM and RAM and the A, D and PC registers.
+ * A machine may be used from one thread at a time; separate machines are
+ * independent. */
+typedef struct hack_machine hack_machine;
+
+/* Why hack_run returned */
+typedef enum
+{
+    HACK_STOP_CYCLES = 0,   /* it ran all the cycles it was given */
+    HACK_STOP_HALT,         /* the program reached an idle loop such as (END) @END 0;JMP */
+    HACK_STOP_BREAKPOINT,   /* the PC arrived at a breakpoint */
+    HACK_STOP_WATCHPOINT,   /* an instruction wrote a watched RAM address */
+    HACK_STOP_ERROR         /* the run failed, as hack_last_error describes */
+} hack_stop;
+
+/* The HACK_API_VERSION the library was built with */
+HACK_API int hack_version(void);
+
+/* A machine with an empty ROM and cleared RAM, or NULL when out of memory */
+HACK_API hack_machine *hack_create(void);
+HACK_API void hack_destroy(hack_machine *machine);
+
+/* Functions returning int return 0 on success and -1 on failure, after which
+ * this describes the failure until the next one */
+HACK_API const char *hack_last_error(hack_machine *machine);
+
+/* Load a program into ROM and reset the CPU; RAM is left as it is. The
+ * program is given as machine words, as the text of a .hack file, or as
+ * Hack assembly. */
+HACK_API int hack_load_words(hack_machine *machine, const uint16_t *words, size_t count);
+HACK_API int hack_load_hack(hack_machine *machine, const char *text, size_t length);
+HACK_API int hack_load_asm(hack_machine *machine, const char *source, size_t length);
+
+/* Sets A, D, PC and the cycle count to 0; RAM is left as it is */
+HACK_API void hack_reset(hack_machine *machine);
+
+/* Sets all of RAM to 0 */
+HACK_API int hack_clear_ram(hack_machine *machine);
+
+/* Runs up to the given number of cycles, stopping early at a halt, a
+ * breakpoint or a watchpoint. A run that starts on a breakpoint executes it. */
+HACK_API hack_stop hack_run(hack_machine *machine, uint64_t cycles);
+
+HACK_API int hack_set_breakpoint(hack_machine *machine, int address, int enabled);
+HACK_API int hack_set_watchpoint(hack_machine *machine, int address, int enabled);
+
+/* The ROM or RAM address of the breakpoint or watchpoint that stopped the last run */
+HACK_API int hack_stop_address(hack_machine *machine);
+
+HACK_API int hack_peek(hack_machine *machine, int address, uint16_t *value);
+HACK_API int hack_poke(hack_machine *machine, int address, uint16_t value);
+
+/* Copy count words of RAM from or to the given address on */
+HACK_API int hack_read_ram(hack_machine *machine, int address, uint16_t *words, size_t count);
+HACK_API int hack_write_ram(hack_machine *machine, int address, const uint16_t *words, size_t count);
+
+HACK_API uint16_t hack_get_a(hack_machine *machine);
+HACK_API uint16_t hack_get_d(hack_machine *machine);
+HACK_API uint16_t hack_get_pc(hack_machine *machine);
+HACK_API uint64_t hack_get_cycles(hack_machine *machine);
+HACK_API int hack_is_halted(hack_machine *machine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HACK_MACHINE_H */
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Heatmap module.
+ */
+
+#include "Heatmap.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <utility>
+
+using namespace std;
+
+// The widest heat strip, in characters
+const int STRIP_WIDTH{64};
+
+// Heat from none to the most, on a log scale
+const string SHADES{" .:-=+*#%@"};
+
+// Addresses listed as the hottest
+const size_t HOTTEST{10};
+
+const int STACK_BASE{256};
+const int HEAP_BASE{2048};
+
+const vector<Segment> &memoryLayout()
+{
+    static const vector<Segment> layout{
+        {"pointers", 0, 4, true},
+        {"temp", 5, 12, true},
+        {"general", 13, 15, true},
+        {"static", 16, STACK_BASE - 1, true},
+        {"stack", STACK_BASE, HEAP_BASE - 1, true},
+        {"heap", HEAP_BASE, SCREEN_ADDRESS - 1, true},
+        {"screen", SCREEN_ADDRESS, KBD_ADDRESS - 1, true},
+        {"keyboard", KBD_ADDRESS, KBD_ADDRESS, false},
+        {"unmapped", KBD_ADDRESS + 1, RAM_SIZE - 1, false}
+    };
+
+    return layout;
+}
+
+// The name of an address for people: its pointer name, or RAM[n]
+static string addressName(int address)
+{
+    static const char *pointers[]{"SP", "LCL", "ARG", "THIS", "THAT"};
+
+    if(address < 5)
+        return string(pointers[address]) + " (RAM[" + to_string(address) + "])";
+
+    return "RAM[" + to_string(address) + "]";
+}
+
+Heatmap::Heatmap() : pendingReads(RAM_SIZE), pendingWrites(RAM_SIZE), reads(RAM_SIZE), writes(RAM_SIZE), pending{0}
+{
+}
+
+void Heatmap::leave(uint64_t executed)
+{
+    pending += executed;
+
+    // an instruction bumps one counter at most, so none can overflow before this
+    if(pending >= PROFILE_CHUNK)
+        flush();
+}
+
+void Heatmap::flush()
+{
+    for(int i = 0; i < RAM_SIZE; i++)
+    {
+        reads[i] += pendingReads[i];
+        writes[i] += pendingWrites[i];
+    }
+
+    fill(pendingReads.begin(), pendingReads.end(), 0);
+    fill(pendingWrites.begin(), pendingWrites.end(), 0);
+    pending = 0;
+}
+
+uint64_t Heatmap::getReads(int address)
+{
+    flush();
+    return reads.at(address);
+}
+
+uint64_t Heatmap::getWrites(int address)
+{
+    flush();
+    return writes.at(address);
+}
+
+int Heatmap::getStackHighWater()
+{
+    flush();
+
+    for(int address = HEAP_BASE - 1; address >= STACK_BASE; address--)
+        if(writes[address])
+            return address;
+
+    return -1;
+}
+
+void Heatmap::report(ostream &out)
+{
+    flush();
+
+    out << left << setw(10) << "Segment" << setw(14) << "Addresses" << right
+        << setw(14) << "Touched" << setw(16) << "Reads" << setw(16) << "Writes" << endl;
+
+    for(const Segment &segment : memoryLayout())
+    {
+        int touched = 0;
+        uint64_t segmentReads = 0, segmentWrites = 0;
+
+        for(int address = segment.first; address <= segment.last; address++)
+        {
+            touched += reads[address] || writes[address];
+            segmentReads += reads[address];
+            segmentWrites += writes[address];
+        }
+
+        out << left << setw(10) << segment.name
+            << setw(14) << (to_string(segment.first) + "-" + to_string(segment.last)) << right
+            << setw(14) << (to_string(touched) + "/" + to_string(segment.last - segment.first + 1))
+            << setw(16) << segmentReads << setw(16) << segmentWrites << endl;
+    }
+
+    // one character per bucket of addresses, shaded by the log of its accesses
+    out << endl << "Heat, from '" << SHADES[1] << "' to '" << SHADES.back() << "':" << endl;
+
+    for(const Segment &segment : memoryLayout())
+    {
+        int size = segment.last - segment.first + 1;
+        int width = min(size, STRIP_WIDTH);
+        int bucket = (size + width - 1) / width;
+        vector<uint64_t> heat;
+
+        for(int first = segment.first; first <= segment.last; first += bucket)
+        {
+            uint64_t sum = 0;
+            for(int address = first; address < first + bucket && address <= segment.last; address++)
+                sum += reads[address] + writes[address];
+            heat.push_back(sum);
+        }
+
+        uint64_t most = *max_element(heat.begin(), heat.end());
+        string strip;
+
+        for(uint64_t sum : heat)
+        {
+            size_t shade = 0;
+            if(sum > 0)
+                shade = most > 1 ? 1 + static_cast<size_t>((SHADES.size() - 2) * log(static_cast<double>(sum)) / log(static_cast<double>(most))) : 1;
+            strip += SHADES[shade];
+        }
+
+        out << left << setw(10) << segment.name << "|" << strip << "|";
+        if(bucket > 1)
+            out << " " << bucket << " addresses each";
+        out << right << endl;
+    }
+
+    vector<pair<uint64_t, int>> hottest;
+    for(int address = 0; address < RAM_SIZE; address++)
+        if(reads[address] || writes[address])
+            hottest.push_back(make_pair(reads[address] + writes[address], address));
+
+    size_t shown = min(hottest.size(), HOTTEST);
+    partial_sort(hottest.begin(), hottest.begin() + shown, hottest.end(), [](const pair<uint64_t, int> &x, const pair<uint64_t, int> &y) {
+        return x.first != y.first ? x.first > y.first : x.second < y.second;
+    });
+
+    out << endl << "Hottest addresses:" << endl;
+    for(size_t i = 0; i < shown; i++)
+    {
+        int address = hottest[i].second;
+        out << "  " << left << setw(20) << addressName(address) << right
+            << setw(16) << reads[address] << " reads" << setw(16) << writes[address] << " writes" << endl;
+    }
+
+    out << endl;
+
+    int highWater = getStackHighWater();
+    if(highWater < 0)
+        out << "The stack was not used" << endl;
+    else
+        out << "Stack high-water mark: RAM[" << highWater << "], " << highWater - STACK_BASE + 1 << " words" << endl;
+
+    // the stack runs into the heap when it outgrows its segment
+    int overflow = -1;
+    for(int address = HEAP_BASE; address < SCREEN_ADDRESS && writes[address]; address++)
+        overflow = address;
+    if(highWater == HEAP_BASE - 1 && overflow >= 0)
+        out << "Warning: the stack may have overflowed into the heap up to RAM[" << overflow << "]" << endl;
+
+    for(const Segment &segment : memoryLayout())
+    {
+        if(segment.writable)
+            continue;
+
+        for(int address = segment.first; address <= segment.last; address++)
+            if(writes[address])
+                out << "Warning: " << writes[address] << " writes to " << segment.name << " address RAM[" << address << "]" << endl;
+    }
+}
+
+void Heatmap::writeCSV(ostream &out)
+{
+    flush();
+
+    out << "address,reads,writes" << endl;
+
+    for(int address = 0; address < RAM_SIZE; address++)
+        if(reads[address] || writes[address])
+            out << address << "," << reads[address] << "," << writes[address] << "\n";
+}
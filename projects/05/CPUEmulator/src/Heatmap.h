@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Heatmap module.
+ */
+
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include "Computer.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// A region of RAM as the VM translator lays it out
+struct Segment
+{
+    std::string name;
+    int first;
+    int last;
+
+    // whether programs are expected to write it
+    bool writable;
+};
+
+// The layout CodeWriter::writePushPop assumes, from SP at 0 to the keyboard
+// and the unmapped addresses above it
+const std::vector<Segment> &memoryLayout();
+
+// Counts the reads and writes of every RAM address by the program, then
+// reports them by segment: how much of each is touched, how hot it is, how
+// high the stack got, and any writes where programs have no business writing.
+// Counts are kept in 32 bits while running and added up into 64 bits every
+// PROFILE_CHUNK instructions, before they could overflow.
+class Heatmap
+{
+public:
+    Heatmap();
+
+    // called by the emulator for every access of M
+    inline void read(uint16_t address);
+    inline void write(uint16_t address);
+
+    // called by the emulator after running the given number of instructions
+    void leave(uint64_t executed);
+
+    uint64_t getReads(int address);
+    uint64_t getWrites(int address);
+
+    // the highest stack address written, or -1 when the stack was not used
+    int getStackHighWater();
+
+    // totals and a heat strip for each segment, the hottest addresses and any stray writes
+    void report(std::ostream &out);
+
+    // address,reads,writes for every address touched
+    void writeCSV(std::ostream &out);
+
+private:
+    std::vector<uint32_t> pendingReads;
+    std::vector<uint32_t> pendingWrites;
+    std::vector<uint64_t> reads;
+    std::vector<uint64_t> writes;
+    uint64_t pending;
+
+    void flush();
+};
+
+inline void Heatmap::read(uint16_t address)
+{
+    pendingReads[address]++;
+}
+
+inline void Heatmap::write(uint16_t address)
+{
+    pendingWrites[address]++;
+}
+
+#endif // HEATMAP_H
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Keyboard module.
+ */
+
+#include "Keyboard.h"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+// The codes of the special keys, as listed in appendix 5
+static const map<string, uint16_t> KEYS{
+    {"space", 32}, {"newline", 128}, {"backspace", 129}, {"left", 130}, {"up", 131},
+    {"right", 132}, {"down", 133}, {"home", 134}, {"end", 135}, {"pageup", 136},
+    {"pagedown", 137}, {"insert", 138}, {"delete", 139}, {"esc", 140},
+    {"f1", 141}, {"f2", 142}, {"f3", 143}, {"f4", 144}, {"f5", 145}, {"f6", 146},
+    {"f7", 147}, {"f8", 148}, {"f9", 149}, {"f10", 150}, {"f11", 151}, {"f12", 152}
+};
+
+KeyboardReplay::KeyboardReplay(istream &script) : next{0}, now{0}
+{
+    string line;
+    int line_no = 0;
+
+    while(getline(script, line))
+    {
+        line_no++;
+
+        size_t comment = line.find("//");
+        if(comment != string::npos)
+            line.erase(comment);
+
+        istringstream words(line);
+        string cycle, action, key, extra;
+
+        if(!(words >> cycle))
+            continue;
+
+        try
+        {
+            words >> action >> key >> extra;
+
+            if(cycle.find_first_not_of("0123456789") != string::npos)
+                throw runtime_error("'" + cycle + "' is not a cycle");
+
+            Event event{stoull(cycle), 0};
+
+            if(action == "press" && !key.empty() && extra.empty())
+                event.code = code(key);
+            else if(action != "release" || !key.empty())
+                throw runtime_error("Expected 'press <key>' or 'release'");
+
+            if(!events.empty() && event.cycle < events.back().cycle)
+                throw runtime_error("Cycle " + cycle + " comes before the previous event");
+
+            events.push_back(event);
+        }
+        catch(logic_error &e)
+        {
+            throw runtime_error("Line " + to_string(line_no) + ": '" + cycle + "' is not a cycle");
+        }
+        catch(runtime_error &e)
+        {
+            throw runtime_error("Line " + to_string(line_no) + ": " + e.what());
+        }
+    }
+}
+
+uint16_t KeyboardReplay::code(const string &key)
+{
+    if(key.size() == 1)
+        return static_cast<unsigned char>(key[0]);
+
+    string name{key};
+    transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return tolower(c); });
+
+    auto special = KEYS.find(name);
+    if(special != KEYS.end())
+        return special->second;
+
+    if(key.find_first_not_of("0123456789") == string::npos && key.size() <= 5 && stoi(key) <= 0x7FFF)
+        return static_cast<uint16_t>(stoi(key));
+
+    throw runtime_error("Unknown key '" + key + "'");
+}
+
+uint64_t KeyboardReplay::due()
+{
+    if(next == events.size())
+        return numeric_limits<uint64_t>::max();
+
+    return events[next].cycle > now ? events[next].cycle - now : 0;
+}
+
+void KeyboardReplay::advance(uint64_t, Computer &computer)
+{
+    now = computer.getCycles();
+
+    // events fall due on the cycles of the computer, which a load resets to 0
+    for(; next < events.size() && events[next].cycle <= now; next++)
+        computer.poke(KBD_ADDRESS, events[next].code);
+}
+
+size_t KeyboardReplay::getPending()
+{
+    return events.size() - next;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Keyboard module.
+ */
+
+#ifndef KEYBOARD_H
+#define KEYBOARD_H
+
+#include "Computer.h"
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+// Presses and releases keys at given cycles by writing their codes to
+// KBD_ADDRESS, so interactive programs can run without anyone at the
+// keyboard. A script has one event per line, at a cycle no earlier than the
+// one before:
+//
+//     // cycle event
+//     100000 press A
+//     150000 release
+//     200000 press newline
+//
+// A key is a single character, one of the names of the special keys of
+// appendix 5 (newline, backspace, left, up, right, down, home, end, pageup,
+// pagedown, insert, delete, esc, f1 to f12, and space), or a code of two or
+// more digits.
+class KeyboardReplay : public Monitor
+{
+public:
+    KeyboardReplay(std::istream &script);
+
+    uint64_t due() override;
+    void advance(uint64_t cycles, Computer &computer) override;
+
+    // the code of a key as the keyboard of chapter 5 reports it
+    static uint16_t code(const std::string &key);
+
+    size_t getPending();
+
+private:
+    struct Event
+    {
+        uint64_t cycle;
+        uint16_t code;
+    };
+
+    std::vector<Event> events;
+    size_t next;
+    uint64_t now;
+};
+
+#endif // KEYBOARD_H
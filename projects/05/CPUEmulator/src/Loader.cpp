@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Loader module.
+ */
+
+#include "Loader.h"
+
+#include "../../../06/Assembler/src/Translator.h"
+#include "../../../06/Assembler/src/Utility.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+static bool hasExtension(const string &filename, const string &extension)
+{
+    return filename.size() >= extension.size() &&
+        filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+vector<uint16_t> Loader::load(const string &filename)
+{
+    string name{filename};
+    ifstream input(name);
+
+    // the test scripts of chapter 4 load a .hack file that only exists after assembling
+    if(!input && hasExtension(name, ".hack"))
+    {
+        name = name.substr(0, name.size() - 5) + ".asm";
+        input.open(name);
+    }
+
+    if(!input)
+        throw runtime_error("Could not open '" + filename + "'");
+
+    try
+    {
+        if(hasExtension(name, ".hack"))
+            return readHack(input);
+        else if(hasExtension(name, ".asm"))
+            return assemble(input);
+        else
+            throw runtime_error("Must end in .hack or .asm");
+    }
+    catch(runtime_error &e)
+    {
+        throw runtime_error(name + ": " + e.what());
+    }
+}
+
+static inline uint16_t reverseBits(uint16_t word)
+{
+    word = static_cast<uint16_t>(((word & 0x5555) << 1) | ((word >> 1) & 0x5555));
+    word = static_cast<uint16_t>(((word & 0x3333) << 2) | ((word >> 2) & 0x3333));
+    word = static_cast<uint16_t>(((word & 0x0F0F) << 4) | ((word >> 4) & 0x0F0F));
+    return static_cast<uint16_t>((word << 8) | (word >> 8));
+}
+
+// Reads 16 characters as a binary word, checking them in the same pass
+static inline bool parseWord(const char *text, uint16_t &word)
+{
+#ifdef __SSE2__
+    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text));
+    __m128i zeros = _mm_cmpeq_epi8(chars, _mm_set1_epi8('0'));
+    __m128i ones = _mm_cmpeq_epi8(chars, _mm_set1_epi8('1'));
+
+    if(_mm_movemask_epi8(_mm_or_si128(zeros, ones)) != 0xFFFF)
+        return false;
+
+    // bit i of the mask is character i, which is the most significant first
+    word = reverseBits(static_cast<uint16_t>(_mm_movemask_epi8(ones)));
+    return true;
+#else
+    word = 0;
+
+    for(int i = 0; i < 16; i++)
+    {
+        if(text[i] != '0' && text[i] != '1')
+            return false;
+        word = static_cast<uint16_t>((word << 1) | (text[i] - '0'));
+    }
+
+    return true;
+#endif
+}
+
+vector<uint16_t> Loader::readHack(istream &input)
+{
+    stringstream buffer;
+    buffer << input.rdbuf();
+    string text = buffer.str();
+    const char *next = text.data();
+    const char *end = next + text.size();
+
+    vector<uint16_t> program;
+    program.reserve(text.size() / 17);
+    int line_no = 0;
+
+    while(next < end)
+    {
+        line_no++;
+
+        const char *eol = static_cast<const char *>(memchr(next, '\n', end - next));
+        if(!eol)
+            eol = end;
+
+        const char *last = eol;
+        if(last > next && last[-1] == '\r')
+            last--;
+
+        uint16_t value;
+
+        // lines as the assembler writes them take the fast path; anything
+        // else is trimmed and checked as before
+        if(last - next == 16 && parseWord(next, value))
+            program.push_back(value);
+        else
+        {
+            string word = trim(string(next, last));
+
+            if(!word.empty())
+            {
+                if(word.size() != 16 || !parseWord(word.data(), value))
+                    throw runtime_error("Line " + to_string(line_no) + ": '" + word + "' is not a 16-bit binary word");
+
+                program.push_back(value);
+            }
+        }
+
+        next = eol + 1;
+    }
+
+    return program;
+}
+
+vector<uint16_t> Loader::assemble(istream &input, SourceMap *map)
+{
+    return Translator::assemble(input, map);
+}
+
+SourceMap Loader::loadMap(const string &filename)
+{
+    SourceMap map;
+    string stem;
+
+    if(hasExtension(filename, ".hack"))
+    {
+        stem = filename.substr(0, filename.size() - 5);
+
+        ifstream mapFile(stem + ".map");
+        if(mapFile)
+        {
+            try
+            {
+                return SourceMapFile::read(mapFile);
+            }
+            catch(runtime_error &e)
+            {
+                throw runtime_error(stem + ".map: " + e.what());
+            }
+        }
+    }
+    else if(hasExtension(filename, ".asm"))
+        stem = filename.substr(0, filename.size() - 4);
+    else
+        return map;
+
+    ifstream source(stem + ".asm");
+    if(source)
+        assemble(source, &map);
+
+    return map;
+}
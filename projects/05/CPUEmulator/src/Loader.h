@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Loader module.
+ */
+
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "../../../06/Assembler/src/SourceMap.h"
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+// Turns .hack and .asm files into ROM images
+namespace Loader
+{
+    // picks the format from the extension of the file; a missing .hack falls back to its .asm
+    std::vector<uint16_t> load(const std::string &filename);
+
+    // reads the output of the assembler: one 16-character binary word per line
+    std::vector<uint16_t> readHack(std::istream &input);
+
+    // assembles Hack assembly in memory with the modules of the chapter 6 assembler,
+    // filling in where each instruction came from when given a map
+    std::vector<uint16_t> assemble(std::istream &input, SourceMap *map = nullptr);
+
+    // the source map of a ROM file: built from an .asm, or read from the .map the
+    // assembler writes next to a .hack; empty when there is neither
+    SourceMap loadMap(const std::string &filename);
+};
+
+#endif // LOADER_H
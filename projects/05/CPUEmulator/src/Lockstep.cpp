@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Lockstep module.
+ */
+
+#include "Lockstep.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+const uint16_t ADDRESS_MASK{0x7FFF};
+
+// Operations on all lanes at once; a mask holds 0xFFFF in selected lanes and 0 elsewhere
+namespace
+{
+#ifdef __AVX2__
+    typedef __m256i Lanes;
+
+    inline Lanes load(const uint16_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+    inline void store(uint16_t *p, Lanes x) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), x); }
+    inline Lanes splat(uint16_t value) { return _mm256_set1_epi16(static_cast<short>(value)); }
+    inline Lanes add(Lanes x, Lanes y) { return _mm256_add_epi16(x, y); }
+    inline Lanes both(Lanes x, Lanes y) { return _mm256_and_si256(x, y); }
+    inline Lanes flip(Lanes x) { return _mm256_xor_si256(x, _mm256_set1_epi16(-1)); }
+    inline Lanes equal(Lanes x, Lanes y) { return _mm256_cmpeq_epi16(x, y); }
+    inline Lanes negative(Lanes x) { return _mm256_cmpgt_epi16(_mm256_setzero_si256(), x); }
+    inline Lanes positive(Lanes x) { return _mm256_cmpgt_epi16(x, _mm256_setzero_si256()); }
+    inline Lanes either(Lanes x, Lanes y) { return _mm256_or_si256(x, y); }
+    inline Lanes select(Lanes mask, Lanes yes, Lanes no) { return _mm256_blendv_epi8(no, yes, mask); }
+
+    inline uint32_t bits(Lanes mask)
+    {
+        // narrow each lane to a byte, then take one bit per byte
+        Lanes packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(mask, _mm256_setzero_si256()), 0xD8);
+        return static_cast<uint32_t>(_mm256_movemask_epi8(packed)) & 0xFFFF;
+    }
+
+    inline Lanes lanesOf(uint32_t bits)
+    {
+        const Lanes lane = _mm256_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, -32768);
+        return _mm256_cmpeq_epi16(_mm256_and_si256(splat(bits), lane), lane);
+    }
+#else
+    struct Lanes
+    {
+        uint16_t v[LANES];
+    };
+
+    inline Lanes load(const uint16_t *p) { Lanes r; copy(p, p + LANES, r.v); return r; }
+    inline void store(uint16_t *p, Lanes x) { copy(x.v, x.v + LANES, p); }
+    inline Lanes splat(uint16_t value) { Lanes r; fill(r.v, r.v + LANES, value); return r; }
+
+    template <typename F>
+    inline Lanes map(Lanes x, Lanes y, F f)
+    {
+        Lanes r;
+        for(int i = 0; i < LANES; i++)
+            r.v[i] = f(x.v[i], y.v[i]);
+        return r;
+    }
+
+    inline Lanes add(Lanes x, Lanes y) { return map(x, y, [](uint16_t p, uint16_t q) { return static_cast<uint16_t>(p + q); }); }
+    inline Lanes both(Lanes x, Lanes y) { return map(x, y, [](uint16_t p, uint16_t q) { return static_cast<uint16_t>(p & q); }); }
+    inline Lanes either(Lanes x, Lanes y) { return map(x, y, [](uint16_t p, uint16_t q) { return static_cast<uint16_t>(p | q); }); }
+    inline Lanes flip(Lanes x) { return map(x, x, [](uint16_t p, uint16_t) { return static_cast<uint16_t>(~p); }); }
+    inline Lanes equal(Lanes x, Lanes y) { return map(x, y, [](uint16_t p, uint16_t q) { return static_cast<uint16_t>(p == q ? 0xFFFF : 0); }); }
+    inline Lanes negative(Lanes x) { return map(x, x, [](uint16_t p, uint16_t) { return static_cast<uint16_t>(static_cast<int16_t>(p) < 0 ? 0xFFFF : 0); }); }
+    inline Lanes positive(Lanes x) { return map(x, x, [](uint16_t p, uint16_t) { return static_cast<uint16_t>(static_cast<int16_t>(p) > 0 ? 0xFFFF : 0); }); }
+    inline Lanes select(Lanes mask, Lanes yes, Lanes no) { return either(both(mask, yes), both(flip(mask), no)); }
+
+    inline uint32_t bits(Lanes mask)
+    {
+        uint32_t r = 0;
+        for(int i = 0; i < LANES; i++)
+            r |= (mask.v[i] ? 1u : 0u) << i;
+        return r;
+    }
+
+    inline Lanes lanesOf(uint32_t bits)
+    {
+        Lanes r;
+        for(int i = 0; i < LANES; i++)
+            r.v[i] = (bits >> i) & 1 ? 0xFFFF : 0;
+        return r;
+    }
+#endif
+
+    // the ALU of chapter 2 over every lane
+    inline Lanes compute(uint8_t alu, Lanes x, Lanes y)
+    {
+        if(alu & ZX) x = splat(0);
+        if(alu & NX) x = flip(x);
+        if(alu & ZY) y = splat(0);
+        if(alu & NY) y = flip(y);
+
+        Lanes out = (alu & F) ? add(x, y) : both(x, y);
+
+        if(alu & NO) out = flip(out);
+
+        return out;
+    }
+
+    inline int lowest(uint32_t bits)
+    {
+        int lane = 0;
+        while(!((bits >> lane) & 1))
+            lane++;
+        return lane;
+    }
+}
+
+Lockstep::Lockstep(shared_ptr<const Program> program, int lanes) :
+    program{program}, rom{program->data()}, lanes{lanes}, ram(static_cast<size_t>(RAM_SIZE) * LANES, 0),
+    steps{0}, divergentSteps{0}
+{
+    if(lanes < 1 || lanes > LANES)
+        throw runtime_error("Lockstep runs 1 to " + to_string(LANES) + " lanes");
+
+    for(int lane = 0; lane < LANES; lane++)
+    {
+        a[lane] = 0;
+        d[lane] = 0;
+        pc[lane] = 0;
+        skipped[lane] = 0;
+        stoppedAt[lane] = 0;
+        target[lane] = 0;
+        halted[lane] = lane >= lanes;
+        stopped[lane] = true;
+    }
+}
+
+void Lockstep::poke(int lane, int address, uint16_t value)
+{
+    if(lane < 0 || lane >= lanes || address < 0 || address >= RAM_SIZE)
+        throw runtime_error("Lane " + to_string(lane) + ", address " + to_string(address) + " out of range");
+
+    ram[static_cast<size_t>(address) * LANES + lane] = value;
+}
+
+uint16_t Lockstep::peek(int lane, int address)
+{
+    if(lane < 0 || lane >= lanes || address < 0 || address >= RAM_SIZE)
+        throw runtime_error("Lane " + to_string(lane) + ", address " + to_string(address) + " out of range");
+
+    return ram[static_cast<size_t>(address) * LANES + lane];
+}
+
+uint64_t Lockstep::getCycles(int lane)
+{
+    return (stopped[lane] ? stoppedAt[lane] : steps) - skipped[lane];
+}
+
+bool Lockstep::isHalted(int lane)
+{
+    return halted[lane];
+}
+
+uint16_t Lockstep::getPC(int lane)
+{
+    return pc[lane];
+}
+
+uint64_t Lockstep::getSteps()
+{
+    return steps;
+}
+
+uint64_t Lockstep::getDivergentSteps()
+{
+    return divergentSteps;
+}
+
+void Lockstep::stop(int lane)
+{
+    stoppedAt[lane] = steps;
+    stopped[lane] = true;
+}
+
+void Lockstep::run(uint64_t cycles)
+{
+    for(int lane = 0; lane < lanes; lane++)
+    {
+        if(halted[lane] || rom[pc[lane]].halt)
+        {
+            halted[lane] = true;
+            continue;
+        }
+
+        // a resumed lane did not run while it was stopped
+        if(stopped[lane])
+        {
+            skipped[lane] += steps - stoppedAt[lane];
+            stopped[lane] = false;
+        }
+
+        target[lane] = getCycles(lane) + cycles;
+    }
+
+    for(;;)
+    {
+        uint32_t live = 0;
+        uint16_t low = 0xFFFF;
+
+        for(int lane = 0; lane < lanes; lane++)
+        {
+            if(stopped[lane])
+                continue;
+
+            if(getCycles(lane) >= target[lane])
+                stop(lane);
+            else
+            {
+                live |= 1u << lane;
+                low = min(low, pc[lane]);
+            }
+        }
+
+        if(live == 0)
+            break;
+
+        // the lanes furthest behind go first, so lanes leaving a loop early wait for the rest
+        uint32_t active = 0;
+        for(int lane = 0; lane < lanes; lane++)
+            if(((live >> lane) & 1) && pc[lane] == low)
+                active |= 1u << lane;
+
+        if(active == live)
+        {
+            // converged: run until a jump splits the lanes, one halts, or one runs out of cycles
+            uint64_t limit = UINT64_MAX;
+            for(int lane = 0; lane < lanes; lane++)
+                if((live >> lane) & 1)
+                    limit = min(limit, target[lane] - getCycles(lane));
+
+            for(uint64_t i = 0; i < limit; i++)
+                if(step(active))
+                    break;
+        }
+        else
+        {
+            divergentSteps++;
+            step(active);
+
+            for(int lane = 0; lane < lanes; lane++)
+                if(((live & ~active) >> lane) & 1)
+                    skipped[lane]++;
+        }
+    }
+}
+
+// Executes the instruction at the PC shared by the active lanes. Returns
+// whether they no longer share a PC or one of them halted.
+bool Lockstep::step(uint32_t active)
+{
+    int first = lowest(active);
+    const Instruction &ins = rom[pc[first]];
+    Lanes mask = lanesOf(active);
+    Lanes va = load(a);
+    Lanes vpc = load(pc);
+    Lanes next = both(add(vpc, splat(1)), splat(ADDRESS_MASK));
+    bool split = false;
+
+    steps++;
+
+    if(ins.address)
+        va = select(mask, splat(ins.word), va);
+    else
+    {
+        Lanes vd = load(d);
+        Lanes address = both(va, splat(ADDRESS_MASK));
+        uint16_t shared = a[first] & ADDRESS_MASK;
+
+        // when every active lane addresses the same word it is one vector in the interleaved RAM
+        bool uniform = (bits(equal(address, splat(shared))) & active) == active;
+        uint16_t *row = &ram[static_cast<size_t>(shared) * LANES];
+
+        Lanes y = va;
+
+        if(ins.useM)
+        {
+            if(uniform)
+                y = load(row);
+            else
+            {
+                alignas(32) uint16_t gathered[LANES] = {0};
+                for(int lane = 0; lane < lanes; lane++)
+                    if((active >> lane) & 1)
+                        gathered[lane] = ram[static_cast<size_t>(a[lane] & ADDRESS_MASK) * LANES + lane];
+                y = load(gathered);
+            }
+        }
+
+        Lanes out = compute(ins.alu, vd, y);
+
+        if(ins.dest & 1)
+        {
+            if(uniform)
+                store(row, select(mask, out, load(row)));
+            else
+            {
+                alignas(32) uint16_t scattered[LANES];
+                store(scattered, out);
+                for(int lane = 0; lane < lanes; lane++)
+                    if((active >> lane) & 1)
+                        ram[static_cast<size_t>(a[lane] & ADDRESS_MASK) * LANES + lane] = scattered[lane];
+            }
+        }
+
+        if(ins.dest & 2)
+            store(d, select(mask, out, vd));
+
+        if(ins.dest & 4)
+            va = select(mask, out, va);
+
+        if(ins.jump)
+        {
+            Lanes taken = mask;
+
+            if(ins.jump != 7)
+            {
+                Lanes condition = splat(0);
+                if(ins.jump & 4) condition = either(condition, negative(out));
+                if(ins.jump & 2) condition = either(condition, equal(out, splat(0)));
+                if(ins.jump & 1) condition = either(condition, positive(out));
+                taken = both(condition, mask);
+            }
+
+            uint32_t jumped = bits(taken) & active;
+            split = jumped != 0 && jumped != active;
+
+            next = select(taken, address, next);
+        }
+    }
+
+    store(a, va);
+    store(pc, select(mask, next, vpc));
+
+    // a lane reaching an idle loop stops for good; unless the lanes split they all reached the same one
+    if(!split && !rom[pc[first]].halt)
+        return false;
+
+    for(int lane = 0; lane < lanes; lane++)
+        if(((active >> lane) & 1) && rom[pc[lane]].halt)
+        {
+            halted[lane] = true;
+            stop(lane);
+        }
+
+    return true;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Lockstep module.
+ */
+
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include "Computer.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+const int LANES{16};
+
+// Runs up to LANES instances of one program side by side, one per 16-bit
+// vector lane, for fuzzing a ROM with many initial RAM images. While the
+// instances agree on the PC each instruction is executed once for all of
+// them; when a jump splits them the lanes at the lowest PC run alone, with
+// the others masked off, until the PCs meet again.
+//
+// With LOCKSTEP_AVX2 set the lanes are one 256-bit register, otherwise a
+// plain array the compiler may vectorize on its own.
+class Lockstep
+{
+public:
+    Lockstep(std::shared_ptr<const Program> program, int lanes);
+
+    void poke(int lane, int address, uint16_t value);
+    uint16_t peek(int lane, int address);
+
+    // runs every lane for up to the given number of further cycles, stopping lanes that halt
+    void run(uint64_t cycles);
+
+    uint64_t getCycles(int lane);
+    bool isHalted(int lane);
+    uint16_t getPC(int lane);
+
+    // group steps taken, and how many of those ran only part of the lanes
+    uint64_t getSteps();
+    uint64_t getDivergentSteps();
+
+private:
+    std::shared_ptr<const Program> program;
+    const Instruction *rom;
+    int lanes;
+
+    // interleaved by lane, so a word at the same address in every lane is one vector
+    std::vector<uint16_t> ram;
+
+    alignas(32) uint16_t a[LANES];
+    alignas(32) uint16_t d[LANES];
+    alignas(32) uint16_t pc[LANES];
+
+    // a lane has run steps - skipped[lane] cycles, frozen at stoppedAt once it stops
+    uint64_t steps;
+    uint64_t divergentSteps;
+    uint64_t skipped[LANES];
+    uint64_t stoppedAt[LANES];
+    uint64_t target[LANES];
+    bool halted[LANES];
+    bool stopped[LANES];
+
+    void stop(int lane);
+    bool step(uint32_t active);
+};
+
+#endif // LOCKSTEP_H
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Profiler module.
+ */
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iomanip>
+#include <map>
+#include <utility>
+
+using namespace std;
+
+const string NO_FUNCTION{"(none)"};
+
+Profiler::Profiler(bool jumps) : jumps{jumps}, counts(ROM_SIZE, 0), taken(ROM_SIZE, 0),
+    arrived(ROM_SIZE, 0), departed(ROM_SIZE, 0), stopped(ROM_SIZE, 0), pending{0}
+{
+}
+
+void Profiler::leave(uint16_t pc, uint64_t executed)
+{
+    stopped[pc]++;
+
+    // the narrow counters cannot reach their limit before the flush
+    pending += executed + 1;
+    if(pending >= PROFILE_CHUNK)
+        flush();
+}
+
+void Profiler::flush()
+{
+    uint64_t fellThrough = 0;
+
+    for(int address = 0; address < ROM_SIZE; address++)
+    {
+        uint64_t count = fellThrough + arrived[address] - stopped[address];
+
+        counts[address] += count;
+        taken[address] += departed[address];
+        fellThrough = count - departed[address];
+
+        arrived[address] = 0;
+        departed[address] = 0;
+        stopped[address] = 0;
+    }
+
+    pending = 0;
+}
+
+uint64_t Profiler::getCount(int address)
+{
+    flush();
+    return counts.at(address);
+}
+
+uint64_t Profiler::getTaken(int address)
+{
+    flush();
+    return taken.at(address);
+}
+
+// Whether an instruction as written in the map jumps only some of the time
+static bool isConditional(const SourceLine &source)
+{
+    size_t semicolon = source.instruction.find(';');
+
+    return semicolon != string::npos && source.instruction.compare(semicolon, string::npos, ";JMP") != 0;
+}
+
+// Return labels of the translator are ret_<n>; the book's convention is Foo.bar$ret.<n>
+static bool isFunctionLabel(const string &label)
+{
+    if(label.empty() || label.find('$') != string::npos)
+        return false;
+
+    if(label.compare(0, 4, "ret_") == 0 && label.size() > 4 &&
+       all_of(label.begin() + 4, label.end(), [](char c) { return isdigit(c); }))
+        return false;
+
+    return true;
+}
+
+vector<string> functionNames(const SourceMap &map)
+{
+    vector<string> names(ROM_SIZE, NO_FUNCTION);
+    string current = NO_FUNCTION;
+
+    for(size_t address = 0; address < map.size() && address < names.size(); address++)
+    {
+        if(isFunctionLabel(map[address].label))
+            current = map[address].label;
+
+        names[address] = current;
+    }
+
+    return names;
+}
+
+void Profiler::report(ostream &out, const SourceMap &map, int top)
+{
+    flush();
+
+    vector<string> names = functionNames(map);
+    std::map<string, uint64_t> totals;
+    uint64_t total = 0;
+
+    for(int address = 0; address < ROM_SIZE; address++)
+        if(counts[address])
+        {
+            totals[names[address]] += counts[address];
+            total += counts[address];
+        }
+
+    vector<pair<uint64_t, string>> order;
+    for(auto &function : totals)
+        order.push_back(make_pair(function.second, function.first));
+    sort(order.begin(), order.end(), [](const pair<uint64_t, string> &x, const pair<uint64_t, string> &y)
+    {
+        return x.first != y.first ? x.first > y.first : x.second < y.second;
+    });
+
+    auto percent = [total](uint64_t count)
+    {
+        return 100.0 * count / (total ? total : 1);
+    };
+
+    out << "Profile of " << total << " instructions" << endl << endl;
+    out << left << setw(40) << "Function" << right << setw(16) << "Instructions" << setw(9) << "%" << endl;
+
+    for(auto &function : order)
+        out << left << setw(40) << function.second << right << setw(16) << function.first
+            << setw(8) << fixed << setprecision(2) << percent(function.first) << "%" << endl;
+
+    for(auto &function : order)
+    {
+        vector<int> addresses;
+        for(int address = 0; address < ROM_SIZE; address++)
+            if(counts[address] && names[address] == function.second)
+                addresses.push_back(address);
+
+        stable_sort(addresses.begin(), addresses.end(), [this](int x, int y) { return counts[x] > counts[y]; });
+
+        if(static_cast<int>(addresses.size()) > top)
+            addresses.resize(top);
+
+        out << endl << function.second << endl;
+
+        for(int address : addresses)
+        {
+            out << right << setw(16) << counts[address] << setw(8) << fixed << setprecision(2)
+                << percent(counts[address]) << "%  ROM[" << address << "]";
+
+            bool mapped = static_cast<size_t>(address) < map.size();
+
+            if(mapped)
+            {
+                const SourceLine &source = map[address];
+                out << " line " << source.line << "  " << source.instruction;
+                if(!source.annotation.empty())
+                    out << "  // " << source.annotation;
+            }
+
+            if(jumps && (mapped ? isConditional(map[address]) : taken[address] != 0))
+                out << "  taken " << taken[address] << ", not taken " << counts[address] - taken[address];
+
+            out << endl;
+        }
+    }
+}
+
+void Profiler::writeCollapsed(ostream &out, const SourceMap &map)
+{
+    flush();
+
+    vector<string> names = functionNames(map);
+    std::map<string, uint64_t> stacks;
+
+    for(int address = 0; address < ROM_SIZE; address++)
+    {
+        if(!counts[address])
+            continue;
+
+        string frame;
+        if(static_cast<size_t>(address) < map.size() && !map[address].annotation.empty())
+            frame = map[address].annotation;
+        else
+            frame = "ROM[" + to_string(address) + "]";
+
+        // ';' separates frames in the format
+        replace(frame.begin(), frame.end(), ';', ',');
+
+        stacks[names[address] + ";" + frame] += counts[address];
+    }
+
+    for(auto &stack : stacks)
+        out << stack.first << " " << stack.second << endl;
+}
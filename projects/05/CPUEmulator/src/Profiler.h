@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Profiler module.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "Computer.h"
+
+#include "../../../06/Assembler/src/SourceMap.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// The most instructions the emulator runs between two calls to Profiler::leave
+const uint64_t PROFILE_CHUNK{1u << 30};
+
+// Counts how often each ROM address executes and how often each jump is
+// taken, then attributes the counts to the source through the assembler's
+// map. Counts are grouped by function: the code from one (Foo.bar) label
+// written by the VM translator up to the next one. Labels holding a '$' and
+// return labels stay in the function around them.
+//
+// The run loop only does work when control does not fall through to the
+// next address. Since an instruction runs exactly as often as control
+// arrives at it, by falling through or otherwise, without the run stopping
+// there, the counts follow from the jumps alone.
+class Profiler
+{
+public:
+    // with jumps, reports list the taken and not-taken counts of conditional jumps
+    Profiler(bool jumps);
+
+    // called by the emulator when a run starts at pc, and when it stops at pc
+    // without executing it after running the given number of instructions
+    inline void enter(uint16_t pc);
+    void leave(uint16_t pc, uint64_t executed);
+
+    // called by the emulator after every instruction, with the PC it moved to
+    inline void record(uint16_t pc, uint16_t next);
+
+    uint64_t getCount(int address);
+    uint64_t getTaken(int address);
+
+    // hot spots by function, listing at most top addresses for each
+    void report(std::ostream &out, const SourceMap &map, int top);
+
+    // function;annotation count lines, as flame graph tools read them
+    void writeCollapsed(std::ostream &out, const SourceMap &map);
+
+private:
+    bool jumps;
+    std::vector<uint64_t> counts;
+    std::vector<uint64_t> taken;
+
+    // since the last flush: arrivals other than by falling through, departures
+    // other than by falling through, and stops
+    std::vector<uint32_t> arrived;
+    std::vector<uint32_t> departed;
+    std::vector<uint32_t> stopped;
+    uint64_t pending;
+
+    // works out the counts since the last flush and adds them to the totals
+    void flush();
+};
+
+// The function around every ROM address, or "(none)" before the first one
+std::vector<std::string> functionNames(const SourceMap &map);
+
+inline void Profiler::enter(uint16_t pc)
+{
+    arrived[pc]++;
+}
+
+inline void Profiler::record(uint16_t pc, uint16_t next)
+{
+    // wrapping from the last address to 0 counts as a jump, so no count depends on itself
+    if(next != pc + 1)
+    {
+        arrived[next]++;
+        departed[pc]++;
+    }
+}
+
+#endif // PROFILER_H
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the ProgramCache module.
+ */
+
+#include "ProgramCache.h"
+#include "Loader.h"
+
+using namespace std;
+
+ProgramCache::ProgramCache(bool haltDetection) : haltDetection{haltDetection}
+{
+}
+
+shared_ptr<const Program> ProgramCache::get(const string &filename)
+{
+    shared_ptr<Entry> entry;
+
+    {
+        lock_guard<mutex> guard(lock);
+        shared_ptr<Entry> &slot = entries[filename];
+        if(!slot)
+            slot = make_shared<Entry>();
+        entry = slot;
+    }
+
+    // the first caller loads outside the lock, so different files load in parallel
+    call_once(entry->loaded, [&]()
+    {
+        try
+        {
+            entry->program = Computer::decode(Loader::load(filename), haltDetection);
+        }
+        catch(...)
+        {
+            entry->error = current_exception();
+        }
+    });
+
+    if(entry->error)
+        rethrow_exception(entry->error);
+
+    return entry->program;
+}
@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Screen module.
+ */
+
+#include "Screen.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+const uint8_t BLACK{0};
+const uint8_t WHITE{255};
+
+Screen::Screen() : dirty{}, words{}, firstChanged{SCREEN_HEIGHT}, lastChanged{-1}
+{
+    fill(begin(pixels), end(pixels), WHITE);
+}
+
+void Screen::touchAll()
+{
+    fill(begin(dirty), end(dirty), ~uint64_t{0});
+}
+
+void Screen::touchNone()
+{
+    fill(begin(dirty), end(dirty), 0);
+}
+
+bool Screen::capture(const uint16_t *ram)
+{
+    return update(ram + SCREEN_ADDRESS);
+}
+
+bool Screen::update(const uint16_t *screen)
+{
+    firstChanged = SCREEN_HEIGHT;
+    lastChanged = -1;
+
+    for(int row = 0; row < SCREEN_HEIGHT; row++)
+    {
+        // untouched blocks of 64 rows are skipped whole
+        if(dirty[row / 64] == 0)
+        {
+            row += 63;
+            continue;
+        }
+
+        if(dirty[row / 64] & (uint64_t{1} << (row % 64)))
+        {
+            uint16_t *copy = words + row * SCREEN_ROW_WORDS;
+            const uint16_t *source = screen + row * SCREEN_ROW_WORDS;
+
+            // a store may well write back what was there
+            if(memcmp(copy, source, SCREEN_ROW_WORDS * sizeof(uint16_t)) == 0)
+                continue;
+
+            memcpy(copy, source, SCREEN_ROW_WORDS * sizeof(uint16_t));
+            unpack(row);
+
+            firstChanged = min(firstChanged, row);
+            lastChanged = max(lastChanged, row);
+        }
+    }
+
+    touchNone();
+
+    return lastChanged >= 0;
+}
+
+// Turns the words of a row into one grey level per pixel, 16 at a time
+void Screen::unpack(int row)
+{
+    const uint16_t *source = words + row * SCREEN_ROW_WORDS;
+    uint8_t *target = pixels + row * SCREEN_WIDTH;
+
+#ifdef __SSE2__
+    // byte i of the mask selects bit i % 8 of the byte that holds pixel i
+    const __m128i mask = _mm_set_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+
+    for(int i = 0; i < SCREEN_ROW_WORDS; i++)
+    {
+        // the low byte of the word in the first eight bytes, the high byte in the last eight
+        const uint64_t spread{0x0101010101010101};
+        __m128i bytes = _mm_set_epi64x(static_cast<int64_t>((source[i] >> 8) * spread), static_cast<int64_t>((source[i] & 0xFF) * spread));
+
+        // a clear bit is a white pixel, and comparing it to zero yields 255
+        __m128i grey = _mm_cmpeq_epi8(_mm_and_si128(bytes, mask), zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + 16 * i), grey);
+    }
+#else
+    for(int i = 0; i < SCREEN_ROW_WORDS; i++)
+        for(int bit = 0; bit < 16; bit++)
+            target[16 * i + bit] = (source[i] >> bit) & 1 ? BLACK : WHITE;
+#endif
+}
+
+int Screen::getFirstChanged()
+{
+    return firstChanged;
+}
+
+int Screen::getLastChanged()
+{
+    return lastChanged;
+}
+
+bool Screen::isBlack(int x, int y)
+{
+    if(x < 0 || x >= SCREEN_WIDTH || y < 0 || y >= SCREEN_HEIGHT)
+        throw runtime_error("Pixel (" + to_string(x) + ", " + to_string(y) + ") is off the screen");
+
+    return pixels[y * SCREEN_WIDTH + x] == BLACK;
+}
+
+void Screen::writeHeader(ostream &out, const char *magic, int first, int last, bool levels)
+{
+    if(first < 0 || last >= SCREEN_HEIGHT || first > last)
+        throw runtime_error("Rows " + to_string(first) + " to " + to_string(last) + " are not on the screen");
+
+    out << magic << "\n";
+    if(first != 0 || last != SCREEN_HEIGHT - 1)
+        out << "# rows " << first << "-" << last << "\n";
+    out << SCREEN_WIDTH << " " << last - first + 1 << "\n";
+    if(levels)
+        out << "255\n";
+}
+
+void Screen::writePBM(ostream &out, int first, int last)
+{
+    writeHeader(out, "P4", first, last, false);
+
+    // a set bit is black in both, but PBM puts the leftmost pixel in the highest bit
+    uint8_t reversed[256];
+    for(int i = 0; i < 256; i++)
+    {
+        reversed[i] = 0;
+        for(int bit = 0; bit < 8; bit++)
+            if(i & (1 << bit))
+                reversed[i] |= 0x80 >> bit;
+    }
+
+    char line[SCREEN_WIDTH / 8];
+    for(int row = first; row <= last; row++)
+    {
+        const uint16_t *source = words + row * SCREEN_ROW_WORDS;
+
+        for(int i = 0; i < SCREEN_ROW_WORDS; i++)
+        {
+            line[2 * i] = static_cast<char>(reversed[source[i] & 0xFF]);
+            line[2 * i + 1] = static_cast<char>(reversed[source[i] >> 8]);
+        }
+
+        out.write(line, sizeof(line));
+    }
+}
+
+void Screen::writePPM(ostream &out, int first, int last)
+{
+    writeHeader(out, "P6", first, last, true);
+
+    char line[SCREEN_WIDTH * 3];
+    for(int row = first; row <= last; row++)
+    {
+        const uint8_t *source = pixels + row * SCREEN_WIDTH;
+
+        for(int x = 0; x < SCREEN_WIDTH; x++)
+            line[3 * x] = line[3 * x + 1] = line[3 * x + 2] = static_cast<char>(source[x]);
+
+        out.write(line, sizeof(line));
+    }
+}
+
+FrameRecorder::FrameRecorder(Screen &screen, const string &prefix, uint64_t interval, bool color, bool diff) :
+    screen(screen), prefix{prefix}, interval{interval}, countdown{interval}, color{color}, diff{diff}, first{true}, frames{0}
+{
+    if(interval == 0)
+        throw runtime_error("The frame interval must be at least one cycle");
+}
+
+uint64_t FrameRecorder::due()
+{
+    return countdown;
+}
+
+void FrameRecorder::advance(uint64_t cycles, Computer &computer)
+{
+    countdown -= min(cycles, countdown);
+
+    if(countdown == 0)
+    {
+        capture(computer);
+        countdown = interval;
+    }
+}
+
+void FrameRecorder::finish(Computer &computer)
+{
+    if(countdown != interval)
+        capture(computer);
+}
+
+int FrameRecorder::getFrames()
+{
+    return frames;
+}
+
+void FrameRecorder::capture(Computer &computer)
+{
+    // the first frame is always written, blank or not, so later diffs have something to apply to
+    if(!screen.capture(computer.getRAM()) && !first)
+        return;
+
+    stringstream name;
+    name << prefix << "_" << setw(6) << setfill('0') << frames << (color ? ".ppm" : ".pbm");
+
+    ofstream out(name.str(), ios::binary);
+    if(!out)
+        throw runtime_error("Could not write the frame '" + name.str() + "'");
+
+    int top = 0, bottom = SCREEN_HEIGHT - 1;
+    if(diff && !first)
+    {
+        top = screen.getFirstChanged();
+        bottom = screen.getLastChanged();
+    }
+
+    if(color)
+        screen.writePPM(out, top, bottom);
+    else
+        screen.writePBM(out, top, bottom);
+
+    first = false;
+    frames++;
+}
+
+static bool hasExtension(const string &filename, const string &extension)
+{
+    return filename.size() >= extension.size() &&
+        filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+void writeScreenshot(Computer &computer, const string &filename)
+{
+    bool color = hasExtension(filename, ".ppm");
+
+    if(!color && !hasExtension(filename, ".pbm"))
+        throw runtime_error("Screenshot '" + filename + "' must end in .pbm or .ppm");
+
+    unique_ptr<Screen> screen(new Screen);
+
+    screen->touchAll();
+    screen->capture(computer.getRAM());
+
+    ofstream out(filename, ios::binary);
+    if(!out)
+        throw runtime_error("Could not write the screenshot '" + filename + "'");
+
+    if(color)
+        screen->writePPM(out);
+    else
+        screen->writePBM(out);
+}
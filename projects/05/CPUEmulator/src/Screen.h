@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Screen module.
+ */
+
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include "Computer.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+const int SCREEN_WIDTH{512};
+const int SCREEN_HEIGHT{256};
+const int SCREEN_ROW_WORDS{SCREEN_WIDTH / 16};
+const int SCREEN_WORDS{SCREEN_HEIGHT * SCREEN_ROW_WORDS};
+
+// The 512x256 black and white display mapped at SCREEN_ADDRESS. Row r takes
+// the 32 words from SCREEN_ADDRESS + 32 * r, and the lowest bit of each word
+// is its leftmost pixel. The computer marks the rows that programs store
+// into, so a capture only looks at those.
+class Screen
+{
+public:
+    Screen();
+
+    // marks the row of a RAM address as dirty, when it lies on the screen
+    inline void touch(int address);
+    void touchAll();
+    void touchNone();
+
+    // copies the dirty rows out of RAM and unpacks their pixels; whether any
+    // pixel changed since the previous capture
+    bool capture(const uint16_t *ram);
+
+    // the same, from the SCREEN_WORDS words of a copy of the screen alone
+    bool update(const uint16_t *screen);
+
+    // the band of rows the last capture changed, when it changed any
+    int getFirstChanged();
+    int getLastChanged();
+
+    bool isBlack(int x, int y);
+
+    // binary PBM (P4) and PPM (P6) images of the given rows
+    void writePBM(std::ostream &out, int first = 0, int last = SCREEN_HEIGHT - 1);
+    void writePPM(std::ostream &out, int first = 0, int last = SCREEN_HEIGHT - 1);
+
+private:
+    uint64_t dirty[SCREEN_HEIGHT / 64];
+    uint16_t words[SCREEN_WORDS];
+
+    // one grey level per pixel: 0 for black, 255 for white
+    uint8_t pixels[SCREEN_HEIGHT * SCREEN_WIDTH];
+
+    int firstChanged;
+    int lastChanged;
+
+    void unpack(int row);
+    void writeHeader(std::ostream &out, const char *magic, int first, int last, bool levels);
+};
+
+inline void Screen::touch(int address)
+{
+    unsigned offset = static_cast<unsigned>(address - SCREEN_ADDRESS);
+
+    if(offset < static_cast<unsigned>(SCREEN_WORDS))
+    {
+        unsigned row = offset / SCREEN_ROW_WORDS;
+        dirty[row / 64] |= uint64_t{1} << (row % 64);
+    }
+}
+
+// Captures the screen every so many cycles and writes a numbered image file,
+// <prefix>_000000.pbm and so on, whenever it changed. In diff mode a file
+// only holds the band of rows that changed, with the first and last of them
+// in a comment of its header.
+class FrameRecorder : public Monitor
+{
+public:
+    FrameRecorder(Screen &screen, const std::string &prefix, uint64_t interval, bool color, bool diff);
+
+    uint64_t due() override;
+    void advance(uint64_t cycles, Computer &computer) override;
+
+    // captures what the last interval left on the screen
+    void finish(Computer &computer);
+
+    int getFrames();
+
+private:
+    Screen &screen;
+    std::string prefix;
+    uint64_t interval;
+    uint64_t countdown;
+    bool color;
+    bool diff;
+    bool first;
+    int frames;
+
+    void capture(Computer &computer);
+};
+
+// Writes the whole screen of a computer to a PBM or PPM file, chosen by its extension
+void writeScreenshot(Computer &computer, const std::string &filename);
+
+#endif // SCREEN_H
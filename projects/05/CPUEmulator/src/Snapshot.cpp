@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Snapshot module.
+ */
+
+#include "Snapshot.h"
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <vector>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+const char MAGIC[]{"HACKSNP1"};
+const uint32_t VERSION{1};
+
+// RAM starts one page into the file, so it maps page-aligned
+const size_t HEADER_SIZE{4096};
+const size_t FILE_SIZE{HEADER_SIZE + RAM_SIZE * sizeof(uint16_t)};
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t romHash;
+    uint64_t cycles;
+    uint16_t a;
+    uint16_t d;
+    uint16_t pc;
+};
+
+uint64_t Snapshot::hash(const Program &program)
+{
+    uint64_t value = 14695981039346656037ull;
+
+    for(const Instruction &ins : program)
+    {
+        value = (value ^ (ins.word & 0xFF)) * 1099511628211ull;
+        value = (value ^ (ins.word >> 8)) * 1099511628211ull;
+    }
+
+    return value;
+}
+
+void Snapshot::save(Computer &computer, const string &filename)
+{
+    ofstream output(filename, ios::binary);
+
+    if(!output)
+        throw runtime_error("Could not open '" + filename + "'");
+
+    char header[HEADER_SIZE] = {0};
+    Header fields;
+
+    // Clear the padding too, so no stack garbage ends up in the file
+    memset(&fields, 0, sizeof(fields));
+    memcpy(fields.magic, MAGIC, sizeof(fields.magic));
+    fields.version = VERSION;
+    fields.headerSize = HEADER_SIZE;
+    fields.romHash = hash(*computer.getProgram());
+    fields.cycles = computer.getCycles();
+    fields.a = computer.getA();
+    fields.d = computer.getD();
+    fields.pc = computer.getPC();
+    memcpy(header, &fields, sizeof(fields));
+
+    output.write(header, HEADER_SIZE);
+
+    for(int address = 0; address < RAM_SIZE; address++)
+    {
+        uint16_t word = computer.peek(address);
+        output.write(reinterpret_cast<const char *>(&word), sizeof(word));
+    }
+
+    if(!output.flush())
+        throw runtime_error("Could not write '" + filename + "'");
+}
+
+#ifdef _WIN32
+// Without mmap the file is read into memory the computer owns
+static shared_ptr<char> map(const string &filename)
+{
+    ifstream input(filename, ios::binary);
+
+    if(!input)
+        throw runtime_error("Could not open '" + filename + "'");
+
+    shared_ptr<char> data(new char[FILE_SIZE], default_delete<char[]>());
+
+    if(!input.read(data.get(), FILE_SIZE) || input.peek() != EOF)
+        throw runtime_error("'" + filename + "' is not a snapshot");
+
+    return data;
+}
+#else
+static shared_ptr<char> map(const string &filename)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+
+    if(fd < 0)
+        throw runtime_error("Could not open '" + filename + "'");
+
+    struct stat status;
+
+    if(fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) != FILE_SIZE)
+    {
+        close(fd);
+        throw runtime_error("'" + filename + "' is not a snapshot");
+    }
+
+    // private and writable: the first write to a page copies it, leaving the file alone
+    void *data = mmap(nullptr, FILE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(data == MAP_FAILED)
+        throw runtime_error("Could not map '" + filename + "'");
+
+    return shared_ptr<char>(static_cast<char *>(data), [](char *p) { munmap(p, FILE_SIZE); });
+}
+#endif
+
+void Snapshot::restore(Computer &computer, const string &filename)
+{
+    shared_ptr<char> data = map(filename);
+    Header fields;
+
+    memcpy(&fields, data.get(), sizeof(fields));
+
+    if(memcmp(fields.magic, MAGIC, sizeof(fields.magic)) != 0 || fields.version != VERSION ||
+       fields.headerSize != HEADER_SIZE)
+        throw runtime_error("'" + filename + "' is not a snapshot");
+
+    if(fields.romHash != hash(*computer.getProgram()))
+        throw runtime_error("'" + filename + "' was taken from a different program");
+
+    // RAM keeps the whole mapping alive
+    computer.setRAM(shared_ptr<uint16_t>(data, reinterpret_cast<uint16_t *>(data.get() + HEADER_SIZE)));
+    computer.setA(fields.a);
+    computer.setD(fields.d);
+    computer.setPC(fields.pc);
+    computer.setCycles(fields.cycles);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Snapshot module.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "Computer.h"
+
+#include <cstdint>
+#include <string>
+
+// Saves and restores the complete state of a computer: PC, A, D, the cycle
+// count and RAM. A snapshot is tied to the program it was taken from by a
+// hash of the ROM, and restoring it into a computer running anything else
+// fails.
+//
+// The file is a one-page header followed by RAM as it lies in memory, so a
+// restore simply maps the file copy-on-write: pages the program never
+// writes are shared with the page cache and every other computer restored
+// from the same snapshot, and the file itself is never modified. Files are
+// only portable between machines of the same byte order.
+namespace Snapshot
+{
+    void save(Computer &computer, const std::string &filename);
+    void restore(Computer &computer, const std::string &filename);
+
+    // FNV-1a over every ROM word
+    uint64_t hash(const Program &program);
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the StackSampler module.
+ */
+
+#include "StackSampler.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+const int LCL{1};
+
+// Where a return address and the saved LCL lie below the LCL of a frame
+const int SAVED_RETURN{5};
+const int SAVED_LCL{4};
+
+// Deeper stacks are cut off; a corrupted chain of frames could otherwise loop forever
+const size_t MAX_DEPTH{1024};
+
+StackSampler::StackSampler(uint64_t interval) : interval{interval}, countdown{interval}, samples{0}
+{
+    if(interval == 0)
+        throw runtime_error("The sampling interval must be at least one cycle");
+}
+
+uint64_t StackSampler::due()
+{
+    return countdown;
+}
+
+void StackSampler::advance(uint64_t cycles, Computer &computer)
+{
+    countdown -= min(cycles, countdown);
+
+    if(countdown == 0)
+    {
+        sample(computer);
+        countdown = interval;
+    }
+}
+
+uint64_t StackSampler::getSamples()
+{
+    return samples;
+}
+
+void StackSampler::sample(Computer &computer)
+{
+    vector<uint16_t> stack{computer.getPC()};
+    int lcl = computer.peek(LCL);
+
+    // the stack grows upwards, so every caller's frame lies below its callee's;
+    // the bootstrap code calls Sys.init with a LCL of 0
+    while(lcl >= SAVED_RETURN && lcl < RAM_SIZE && stack.size() < MAX_DEPTH)
+    {
+        stack.push_back(computer.peek(lcl - SAVED_RETURN));
+
+        int caller = computer.peek(lcl - SAVED_LCL);
+        if(caller >= lcl)
+            break;
+
+        lcl = caller;
+    }
+
+    stacks[stack]++;
+    samples++;
+}
+
+vector<string> StackSampler::name(const vector<uint16_t> &stack, const vector<string> &functions)
+{
+    vector<string> names;
+
+    // oldest caller first
+    for(size_t i = stack.size(); i-- > 0;)
+    {
+        // the call itself is the jump just before its return address; the
+        // return address may already be the first one of the next function
+        int address = i > 0 && stack[i] > 0 ? stack[i] - 1 : stack[i];
+
+        names.push_back(static_cast<size_t>(address) < functions.size() ? functions[address] : "ROM[" + to_string(address) + "]");
+    }
+
+    return names;
+}
+
+void StackSampler::report(ostream &out, const SourceMap &map)
+{
+    vector<string> functions = functionNames(map);
+    std::map<string, uint64_t> inclusive, exclusive;
+
+    for(auto &stack : stacks)
+    {
+        vector<string> names = name(stack.first, functions);
+
+        // a recursive function counts once towards its own inclusive time
+        for(auto &function : set<string>(names.begin(), names.end()))
+            inclusive[function] += stack.second;
+
+        exclusive[names.back()] += stack.second;
+    }
+
+    vector<pair<uint64_t, string>> order;
+    for(auto &function : inclusive)
+        order.push_back(make_pair(function.second, function.first));
+    sort(order.begin(), order.end(), [](const pair<uint64_t, string> &x, const pair<uint64_t, string> &y)
+    {
+        return x.first != y.first ? x.first > y.first : x.second < y.second;
+    });
+
+    auto percent = [this](uint64_t count)
+    {
+        return 100.0 * count / (samples ? samples : 1);
+    };
+
+    out << samples << " samples, one every " << interval << " cycles" << endl << endl;
+    out << left << setw(40) << "Function" << right << setw(16) << "Inclusive" << setw(9) << "%"
+        << setw(16) << "Exclusive" << setw(9) << "%" << endl;
+
+    for(auto &function : order)
+    {
+        uint64_t own = exclusive[function.second];
+
+        out << left << setw(40) << function.second << right
+            << setw(16) << function.first * interval << setw(8) << fixed << setprecision(2) << percent(function.first) << "%"
+            << setw(16) << own * interval << setw(8) << percent(own) << "%" << endl;
+    }
+}
+
+void StackSampler::writeCollapsed(ostream &out, const SourceMap &map)
+{
+    vector<string> functions = functionNames(map);
+    std::map<string, uint64_t> lines;
+
+    for(auto &stack : stacks)
+    {
+        vector<string> names = name(stack.first, functions);
+        string line;
+
+        for(size_t i = 0; i < names.size(); i++)
+            line += (i ? ";" : "") + names[i];
+
+        lines[line] += stack.second * interval;
+    }
+
+    for(auto &line : lines)
+        out << line.first << " " << line.second << endl;
+}
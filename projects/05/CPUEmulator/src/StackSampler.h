@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the StackSampler module.
+ */
+
+#ifndef STACK_SAMPLER_H
+#define STACK_SAMPLER_H
+
+#include "Computer.h"
+
+#include "../../../06/Assembler/src/SourceMap.h"
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <vector>
+
+// Samples the VM call stack of a program built by the VM translator every
+// so many cycles. The stack is read from the frames the calling convention
+// leaves in RAM: below the LCL of every function lie the return address and
+// the LCL, ARG, THIS and THAT of its caller, as CodeWriter::writeCall pushes
+// them. Return addresses are named after the function around them through
+// the assembler's map, so the program itself needs no changes.
+class StackSampler : public Monitor
+{
+public:
+    StackSampler(uint64_t interval);
+
+    uint64_t due() override;
+    void advance(uint64_t cycles, Computer &computer) override;
+
+    // inclusive and exclusive cycles by function, estimated from the samples
+    void report(std::ostream &out, const SourceMap &map);
+
+    // one line of caller;...;callee and its cycles per distinct stack, as flame graph tools read them
+    void writeCollapsed(std::ostream &out, const SourceMap &map);
+
+    uint64_t getSamples();
+
+private:
+    uint64_t interval;
+    uint64_t countdown;
+    uint64_t samples;
+
+    // the PC, then the return address of every frame out to the oldest
+    std::map<std::vector<uint16_t>, uint64_t> stacks;
+
+    void sample(Computer &computer);
+    std::vector<std::string> name(const std::vector<uint16_t> &stack, const std::vector<std::string> &functions);
+};
+
+#endif // STACK_SAMPLER_H
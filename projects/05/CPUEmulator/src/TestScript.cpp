@@ -0,0 +1,564 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the TestScript module.
+ */
+
+#include "TestScript.h"
+#include "Loader.h"
+#include "Screen.h"
+#include "Snapshot.h"
+
+#include <cctype>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+const int64_t FOREVER{-1};
+const int REGISTER{-1};
+
+TestScript::TestScript(istream &inputStream, const string &directory, Computer &computer) :
+    input{inputStream}, computer(computer), directory{directory}, cache{nullptr}, echo{&cout}, comparing{false}, line_no{1}, output_line{0}
+{
+}
+
+void TestScript::run()
+{
+    // the whole script is parsed before anything runs, so syntax errors never leave partial output
+    vector<Token> tokens = tokenize(input);
+    size_t pos = 0;
+
+    script = parseBlock(tokens, pos, false);
+
+    execute(script);
+}
+
+bool TestScript::isInterrupted()
+{
+    Stop stop = computer.getStop();
+
+    return stop == Stop::BREAKPOINT || stop == Stop::WATCHPOINT || stop == Stop::LIMIT;
+}
+
+bool TestScript::hasComparison()
+{
+    return comparing;
+}
+
+void TestScript::setProgramCache(ProgramCache *programCache)
+{
+    cache = programCache;
+}
+
+void TestScript::setEcho(ostream &stream)
+{
+    echo = &stream;
+}
+
+int TestScript::getLineNumber()
+{
+    return line_no;
+}
+
+vector<TestScript::Token> TestScript::tokenize(istream &input)
+{
+    string text{istreambuf_iterator<char>(input), istreambuf_iterator<char>()};
+    vector<Token> tokens;
+    int line = 1;
+    size_t i = 0;
+
+    while(i < text.size())
+    {
+        char ch = text[i];
+
+        if(ch == '\n')
+        {
+            line++;
+            i++;
+        }
+        else if(isspace(ch))
+            i++;
+        // line comment
+        else if(text.compare(i, 2, "//") == 0)
+        {
+            while(i < text.size() && text[i] != '\n')
+                i++;
+        }
+        // block comment
+        else if(text.compare(i, 2, "/*") == 0)
+        {
+            size_t end = text.find("*/", i + 2);
+            if(end == string::npos)
+            {
+                line_no = line;
+                throw runtime_error("Unterminated comment");
+            }
+            for(; i < end + 2; i++)
+                if(text[i] == '\n')
+                    line++;
+        }
+        // quoted string, as taken by echo
+        else if(ch == '"')
+        {
+            size_t end = text.find('"', i + 1);
+            if(end == string::npos)
+            {
+                line_no = line;
+                throw runtime_error("Unterminated string");
+            }
+            tokens.push_back({text.substr(i + 1, end - i - 1), line});
+            i = end + 1;
+        }
+        else if(ch == ',' || ch == ';' || ch == '{' || ch == '}')
+        {
+            tokens.push_back({string(1, ch), line});
+            i++;
+        }
+        else
+        {
+            size_t start = i;
+            while(i < text.size() && !isspace(text[i]) && text[i] != ',' && text[i] != ';' &&
+                  text[i] != '{' && text[i] != '}' && text.compare(i, 2, "//") != 0)
+                i++;
+            tokens.push_back({text.substr(start, i - start), line});
+        }
+    }
+
+    return tokens;
+}
+
+vector<TestScript::Command> TestScript::parseBlock(const vector<Token> &tokens, size_t &pos, bool nested)
+{
+    vector<Command> block;
+
+    while(pos < tokens.size())
+    {
+        line_no = tokens[pos].line;
+
+        if(tokens[pos].text == "}")
+        {
+            if(!nested)
+                throw runtime_error("Unexpected '}'");
+            pos++;
+            return block;
+        }
+
+        Command command;
+        command.line = tokens[pos].line;
+        command.count = 0;
+
+        if(tokens[pos].text == "repeat")
+        {
+            command.words.push_back(tokens[pos++].text);
+            command.count = FOREVER;
+
+            // the count is optional; without one the block repeats forever
+            if(pos < tokens.size() && tokens[pos].text != "{")
+            {
+                try
+                {
+                    command.count = stoll(tokens[pos].text);
+                }
+                catch(logic_error &e)
+                {
+                    throw runtime_error("Could not convert '" + tokens[pos].text + "' to a repeat count");
+                }
+                if(command.count < 0)
+                    throw runtime_error("Repeat count must be positive");
+                pos++;
+            }
+
+            if(pos >= tokens.size() || tokens[pos].text != "{")
+                throw runtime_error("Expected '{' after repeat");
+
+            pos++;
+            command.body = parseBlock(tokens, pos, true);
+        }
+        else if(tokens[pos].text == "while")
+            throw runtime_error("'while' is not supported");
+        else
+        {
+            // a simple command runs until its terminator
+            while(pos < tokens.size() && tokens[pos].text != "," && tokens[pos].text != ";")
+            {
+                if(tokens[pos].text == "{" || tokens[pos].text == "}")
+                    throw runtime_error("Unexpected '" + tokens[pos].text + "'");
+                command.words.push_back(tokens[pos++].text);
+            }
+
+            if(pos == tokens.size())
+                throw runtime_error("Missing ',' or ';' after '" + command.words[0] + "'");
+
+            pos++;
+
+            if(command.words.empty())
+                continue;
+        }
+
+        block.push_back(command);
+    }
+
+    if(nested)
+        throw runtime_error("Missing '}'");
+
+    return block;
+}
+
+void TestScript::execute(const vector<Command> &block)
+{
+    for(auto &command : block)
+    {
+        if(isInterrupted())
+            return;
+        execute(command);
+    }
+}
+
+void TestScript::execute(const Command &command)
+{
+    line_no = command.line;
+
+    const vector<string> &words = command.words;
+    const string &name = words[0];
+
+    if(name == "repeat")
+        repeat(command);
+    else if(name == "ticktock" || name == "tock")
+        computer.step();
+    else if(name == "tick")
+    {
+        // a full cycle is simulated on tock
+    }
+    else if(name == "set")
+    {
+        if(words.size() != 3)
+            throw runtime_error("Usage: set <variable> <value>");
+        set(words[1], words[2]);
+    }
+    else if(name == "output")
+    {
+        string line = "|";
+
+        for(auto &column : columns)
+        {
+            int16_t value = static_cast<int16_t>(get(column));
+            string text;
+
+            if(column.format == 'D')
+                text = to_string(value);
+            else
+            {
+                int base = column.format == 'X' ? 16 : 2;
+                int digits = column.format == 'X' ? 4 : 16;
+                uint16_t bits = static_cast<uint16_t>(value);
+
+                text = string(digits, '0');
+                for(int i = digits - 1; i >= 0; i--, bits /= base)
+                    text[i] = "0123456789ABCDEF"[bits % base];
+            }
+
+            if(static_cast<int>(text.size()) > column.length)
+                text = text.substr(text.size() - column.length);
+
+            line += string(column.padLeft + column.length - text.size(), ' ') + text +
+                string(column.padRight, ' ') + "|";
+        }
+
+        writeLine(line);
+    }
+    else if(name == "output-list")
+        setOutputList(words);
+    else if(name == "load")
+    {
+        if(words.size() != 2)
+            throw runtime_error("Usage: load <file.hack|file.asm>");
+        programFile = resolve(words[1]);
+        if(cache)
+            computer.load(cache->get(programFile));
+        else
+            computer.load(Loader::load(programFile));
+    }
+    else if(name == "output-file")
+    {
+        if(words.size() != 2)
+            throw runtime_error("Usage: output-file <file>");
+        output.close();
+        output.open(resolve(words[1]));
+        if(!output)
+            throw runtime_error("Could not open '" + words[1] + "' for writing");
+    }
+    else if(name == "compare-to")
+    {
+        if(words.size() != 2)
+            throw runtime_error("Usage: compare-to <file>");
+        compare.close();
+        compare.open(resolve(words[1]));
+        if(!compare)
+            throw runtime_error("Could not open '" + words[1] + "'");
+        comparing = true;
+    }
+    else if(name == "echo")
+    {
+        for(size_t i = 1; i < words.size(); i++)
+            *echo << words[i] << (i + 1 < words.size() ? " " : "");
+        *echo << endl;
+    }
+    else if(name == "clear-echo")
+    {
+    }
+    else if(name == "save-snapshot")
+    {
+        if(words.size() != 2)
+            throw runtime_error("Usage: save-snapshot <file>");
+        Snapshot::save(computer, resolve(words[1]));
+    }
+    else if(name == "load-snapshot")
+    {
+        if(words.size() != 2)
+            throw runtime_error("Usage: load-snapshot <file>");
+        Snapshot::restore(computer, resolve(words[1]));
+    }
+    else if(name == "screenshot")
+    {
+        if(words.size() != 2)
+            throw runtime_error("Usage: screenshot <file.pbm|file.ppm>");
+        writeScreenshot(computer, resolve(words[1]));
+    }
+    else
+        throw runtime_error("Unknown command '" + name + "'");
+}
+
+void TestScript::repeat(const Command &command)
+{
+    // a body of a single ticktock is just a run of the CPU
+    bool cyclesOnly = command.body.size() == 1 && command.body[0].words[0] == "ticktock";
+
+    if(cyclesOnly)
+    {
+        line_no = command.body[0].line;
+
+        if(command.count != FOREVER)
+            computer.run(command.count);
+        else
+            while(!computer.isHalted() && !isInterrupted())
+                computer.run(UINT32_MAX);
+
+        return;
+    }
+
+    // a halted program will not change again, so an endless repeat is over
+    for(int64_t i = 0; command.count == FOREVER || i < command.count; i++)
+    {
+        if((command.count == FOREVER && computer.isHalted()) || isInterrupted())
+            break;
+        execute(command.body);
+    }
+}
+
+void TestScript::setOutputList(const vector<string> &words)
+{
+    columns.clear();
+
+    string header = "|";
+
+    for(size_t i = 1; i < words.size(); i++)
+    {
+        Column column;
+        string spec = words[i];
+        size_t percent = spec.find('%');
+
+        column.variable = spec.substr(0, percent);
+        column.format = 'D';
+        column.padLeft = 1;
+        column.length = 6;
+        column.padRight = 1;
+
+        // format: %<D|X|B><pad left>.<length>.<pad right>
+        if(percent != string::npos)
+        {
+            string format = spec.substr(percent + 1);
+            char padding;
+
+            if(format.empty() || (format[0] != 'D' && format[0] != 'X' && format[0] != 'B'))
+                throw runtime_error("Invalid output format in '" + spec + "'");
+
+            column.format = format[0];
+
+            istringstream fields(format.substr(1));
+            char dot1 = 0, dot2 = 0;
+            fields >> column.padLeft >> dot1 >> column.length >> dot2 >> column.padRight;
+
+            if(!fields || dot1 != '.' || dot2 != '.' || fields.get(padding) ||
+               column.padLeft < 0 || column.length <= 0 || column.padRight < 0)
+                throw runtime_error("Invalid output format in '" + spec + "'");
+        }
+
+        column.address = REGISTER;
+
+        if(column.variable.compare(0, 4, "RAM[") == 0 && column.variable.back() == ']')
+        {
+            try
+            {
+                column.address = stoi(column.variable.substr(4, column.variable.size() - 5));
+            }
+            catch(logic_error &e)
+            {
+                throw runtime_error("Invalid RAM address in '" + spec + "'");
+            }
+            if(column.address < 0 || column.address >= RAM_SIZE)
+                throw runtime_error("RAM address in '" + spec + "' out of range");
+        }
+        else if(column.variable != "A" && column.variable != "D" && column.variable != "PC" && column.variable != "time")
+            throw runtime_error("Unknown variable '" + column.variable + "'");
+
+        // the name is centred over the column, truncated if it is wider
+        int width = column.padLeft + column.length + column.padRight;
+        string name = column.variable.substr(0, width);
+        int space = width - name.size();
+
+        header += string(space / 2, ' ') + name + string(space - space / 2, ' ') + "|";
+
+        columns.push_back(column);
+    }
+
+    writeLine(header);
+}
+
+void TestScript::set(const string &variable, const string &value)
+{
+    int number;
+
+    try
+    {
+        size_t consumed;
+
+        if(value.size() > 2 && value[0] == '%')
+        {
+            int base = value[1] == 'X' ? 16 : value[1] == 'B' ? 2 : value[1] == 'D' ? 10 : 0;
+            if(base == 0)
+                throw invalid_argument(value);
+            number = stoi(value.substr(2), &consumed, base);
+            consumed += 2;
+        }
+        else
+            number = stoi(value, &consumed, 10);
+
+        if(consumed != value.size())
+            throw invalid_argument(value);
+    }
+    catch(logic_error &e)
+    {
+        throw runtime_error("Could not convert '" + value + "' to a value");
+    }
+
+    if(number < -32768 || number > 65535)
+        throw runtime_error("'" + value + "' does not fit in 16 bits");
+
+    uint16_t word = static_cast<uint16_t>(number);
+
+    if(variable.compare(0, 4, "RAM[") == 0 && variable.back() == ']')
+    {
+        int address;
+
+        try
+        {
+            address = stoi(variable.substr(4, variable.size() - 5));
+        }
+        catch(logic_error &e)
+        {
+            throw runtime_error("Invalid RAM address in '" + variable + "'");
+        }
+
+        computer.poke(address, word);
+    }
+    else if(variable == "A")
+        computer.setA(word);
+    else if(variable == "D")
+        computer.setD(word);
+    else if(variable == "PC")
+        computer.setPC(word);
+    else
+        throw runtime_error("Unknown variable '" + variable + "'");
+}
+
+uint16_t TestScript::get(const Column &column)
+{
+    if(column.address != REGISTER)
+        return computer.peek(column.address);
+    else if(column.variable == "A")
+        return computer.getA();
+    else if(column.variable == "D")
+        return computer.getD();
+    else if(column.variable == "PC")
+        return computer.getPC();
+    else
+        return static_cast<uint16_t>(computer.getCycles());
+}
+
+void TestScript::writeLine(const string &line)
+{
+    output_line++;
+
+    if(output.is_open())
+        output << line << endl;
+
+    if(!comparing)
+        return;
+
+    // compare as we go, so a failure stops the script where it happened
+    string expected;
+
+    if(!getline(compare, expected))
+        throw runtime_error("Comparison failure at line " + to_string(output_line) + ": compare file ended");
+
+    if(!expected.empty() && expected.back() == '\r')
+        expected.pop_back();
+
+    bool match = expected.size() == line.size();
+
+    // '*' in the compare file matches any character
+    for(size_t i = 0; match && i < line.size(); i++)
+        match = expected[i] == '*' || expected[i] == line[i];
+
+    if(!match)
+        throw runtime_error("Comparison failure at line " + to_string(output_line) +
+                            ": expected '" + expected + "' but got '" + line + "'");
+}
+
+string TestScript::getProgramFile()
+{
+    return programFile;
+}
+
+string TestScript::resolve(const string &filename)
+{
+    if(filename.empty() || filename[0] == '/' || directory.empty())
+        return filename;
+
+    return directory + "/" + filename;
+}
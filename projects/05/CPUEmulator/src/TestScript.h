@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the TestScript module.
+ */
+
+#ifndef TEST_SCRIPT_H
+#define TEST_SCRIPT_H
+
+#include "Computer.h"
+#include "ProgramCache.h"
+
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Interprets the subset of the test scripting language (appendix B) used by
+// the CPU emulator scripts: load, output-file, compare-to, output-list, set,
+// output, echo, repeat, tick, tock and ticktock. Two commands of its own,
+// save-snapshot and load-snapshot, let scripts share a long warm-up, and a
+// third, screenshot, writes the screen to a PBM or PPM file.
+class TestScript
+{
+public:
+    // relative file names in the script are resolved against directory
+    TestScript(std::istream &inputStream, const std::string &directory, Computer &computer);
+    void run();
+    bool hasComparison();
+
+    // whether a breakpoint, a watchpoint or the cycle limit of the computer
+    // stopped the script before its end
+    bool isInterrupted();
+
+    // loads go through the cache when one is given, and echo goes to cout unless redirected
+    void setProgramCache(ProgramCache *programCache);
+    void setEcho(std::ostream &stream);
+
+    int getLineNumber();
+
+    // the ROM file named by the last load command, resolved against the directory
+    std::string getProgramFile();
+
+private:
+    struct Command
+    {
+        int line;
+        std::vector<std::string> words;
+        int64_t count;
+        std::vector<Command> body;
+    };
+
+    struct Column
+    {
+        std::string variable;
+        int address;
+        char format;
+        int padLeft;
+        int length;
+        int padRight;
+    };
+
+    struct Token
+    {
+        std::string text;
+        int line;
+    };
+
+    std::istream &input;
+    Computer &computer;
+    std::string directory;
+    std::string programFile;
+    std::vector<Command> script;
+    std::vector<Column> columns;
+    std::ofstream output;
+    std::ifstream compare;
+    ProgramCache *cache;
+    std::ostream *echo;
+    bool comparing;
+    int line_no;
+    int output_line;
+
+    std::vector<Token> tokenize(std::istream &input);
+    std::vector<Command> parseBlock(const std::vector<Token> &tokens, size_t &pos, bool nested);
+
+    void execute(const std::vector<Command> &block);
+    void execute(const Command &command);
+    void repeat(const Command &command);
+
+    void setOutputList(const std::vector<std::string> &words);
+    void set(const std::string &variable, const std::string &value);
+    uint16_t get(const Column &column);
+    void writeLine(const std::string &line);
+
+    std::string resolve(const std::string &filename);
+};
+
+#endif // TEST_SCRIPT_H
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Trace module.
+ */
+
+#include "Trace.h"
+
+#include <chrono>
+#include <stdexcept>
+
+using namespace std;
+
+const char MAGIC[]{"HACKTRC1"};
+const size_t MAGIC_SIZE{8};
+
+enum TraceFlags : uint8_t
+{
+    JUMP  = 0x01,
+    REG_A = 0x02,
+    REG_D = 0x04,
+    WRITE = 0x08
+};
+
+// Maps small differences of either sign to small unsigned numbers
+static uint32_t zigzag(uint16_t from, uint16_t to)
+{
+    int32_t delta = static_cast<int16_t>(static_cast<uint16_t>(to - from));
+    return static_cast<uint32_t>((delta << 1) ^ (delta >> 31));
+}
+
+static uint16_t unzigzag(uint16_t from, uint32_t code)
+{
+    int32_t delta = static_cast<int32_t>(code >> 1) ^ -static_cast<int32_t>(code & 1);
+    return static_cast<uint16_t>(from + delta);
+}
+
+static void putVarint(string &out, uint32_t value)
+{
+    while(value >= 0x80)
+    {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+static uint32_t getVarint(istream &in)
+{
+    uint32_t value = 0;
+
+    for(int shift = 0; shift < 21; shift += 7)
+    {
+        int byte = in.get();
+
+        if(byte == EOF)
+            throw runtime_error("Trace ends in the middle of a record");
+
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+
+        if(!(byte & 0x80))
+            return value;
+    }
+
+    throw runtime_error("Trace holds a malformed number");
+}
+
+TraceWriter::TraceWriter(const string &filename) :
+    output(filename, ios::binary), ring(CAPACITY), head{0}, tail{0}, freeUntil{CAPACITY}, done{false}
+{
+    if(!output)
+        throw runtime_error("Could not open '" + filename + "'");
+
+    output.write(MAGIC, MAGIC_SIZE);
+
+    writer = thread(&TraceWriter::drain, this);
+}
+
+TraceWriter::~TraceWriter()
+{
+    close();
+}
+
+void TraceWriter::close()
+{
+    if(!writer.joinable())
+        return;
+
+    done.store(true, memory_order_release);
+    writer.join();
+    output.close();
+}
+
+void TraceWriter::waitForSpace()
+{
+    // the consumer is behind by a whole buffer; give it the CPU until it catches up
+    while(head.load(memory_order_relaxed) - tail.load(memory_order_acquire) == CAPACITY)
+        this_thread::yield();
+
+    freeUntil = tail.load(memory_order_acquire) + CAPACITY;
+}
+
+void TraceWriter::drain()
+{
+    TraceRecord last{0, 0xFFFF, 0, 0, false, 0, 0};
+    string buffer;
+
+    for(;;)
+    {
+        // read done first, so nothing published before it was set can be missed
+        bool finished = done.load(memory_order_acquire);
+        size_t end = head.load(memory_order_acquire);
+        size_t position = tail.load(memory_order_relaxed);
+
+        if(position == end)
+        {
+            if(finished)
+                break;
+
+            this_thread::sleep_for(chrono::microseconds(100));
+            continue;
+        }
+
+        for(; position != end; position++)
+        {
+            const Entry &entry = ring[position & (CAPACITY - 1)];
+            uint8_t flags = 0;
+
+            if(entry.pc != static_cast<uint16_t>(last.pc + 1))
+                flags |= JUMP;
+            if(entry.a != last.a)
+                flags |= REG_A;
+            if(entry.d != last.d)
+                flags |= REG_D;
+            if(entry.write)
+                flags |= WRITE;
+
+            buffer += static_cast<char>(flags);
+
+            if(flags & JUMP)
+                putVarint(buffer, zigzag(last.pc + 1, entry.pc));
+            if(flags & REG_A)
+                putVarint(buffer, zigzag(last.a, entry.a));
+            if(flags & REG_D)
+                putVarint(buffer, zigzag(last.d, entry.d));
+            if(flags & WRITE)
+            {
+                putVarint(buffer, zigzag(last.address, entry.address));
+                putVarint(buffer, zigzag(last.value, entry.value));
+                last.address = entry.address;
+                last.value = entry.value;
+            }
+
+            last.pc = entry.pc;
+            last.a = entry.a;
+            last.d = entry.d;
+        }
+
+        tail.store(position, memory_order_release);
+
+        output.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+    output.flush();
+}
+
+TraceReader::TraceReader(istream &input) : input(input), last{0, 0xFFFF, 0, 0, false, 0, 0}
+{
+    char magic[MAGIC_SIZE];
+
+    if(!input.read(magic, MAGIC_SIZE) || string(magic, MAGIC_SIZE) != MAGIC)
+        throw runtime_error("Not a trace file");
+}
+
+bool TraceReader::next(TraceRecord &record)
+{
+    int flags = input.get();
+
+    if(flags == EOF)
+        return false;
+
+    if(flags & ~(JUMP | REG_A | REG_D | WRITE))
+        throw runtime_error("Trace holds an unknown record at cycle " + to_string(last.cycle + 1));
+
+    uint16_t pc = last.pc + 1;
+
+    last.pc = (flags & JUMP) ? unzigzag(pc, getVarint(input)) : pc;
+    if(flags & REG_A)
+        last.a = unzigzag(last.a, getVarint(input));
+    if(flags & REG_D)
+        last.d = unzigzag(last.d, getVarint(input));
+
+    last.write = (flags & WRITE) != 0;
+    if(last.write)
+    {
+        last.address = unzigzag(last.address, getVarint(input));
+        last.value = unzigzag(last.value, getVarint(input));
+    }
+
+    last.cycle++;
+    record = last;
+
+    return true;
+}
+
+void printTrace(TraceReader &reader, ostream &out, bool csv)
+{
+    TraceRecord record;
+
+    if(csv)
+        out << "cycle,pc,a,d,address,value\n";
+
+    while(reader.next(record))
+    {
+        int16_t a = static_cast<int16_t>(record.a);
+        int16_t d = static_cast<int16_t>(record.d);
+        int16_t value = static_cast<int16_t>(record.value);
+
+        if(csv)
+        {
+            out << record.cycle << ',' << record.pc << ',' << a << ',' << d << ',';
+            if(record.write)
+                out << record.address << ',' << value;
+            else
+                out << ',';
+            out << '\n';
+        }
+        else
+        {
+            out << record.cycle << ": ROM[" << record.pc << "] A=" << a << " D=" << d;
+            if(record.write)
+                out << " RAM[" << record.address << "]=" << value;
+            out << '\n';
+        }
+    }
+}
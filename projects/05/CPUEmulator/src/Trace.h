@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Trace module.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// What one executed instruction did: the PC it ran at, the registers after
+// it, and the RAM word it wrote, if any
+struct TraceRecord
+{
+    uint64_t cycle;
+    uint16_t pc;
+    uint16_t a;
+    uint16_t d;
+    bool write;
+    uint16_t address;
+    uint16_t value;
+};
+
+// Records an instruction trace to a compact binary file.
+//
+// The file starts with the magic "HACKTRC1", followed by one record per
+// instruction. A record is a flag byte and then, for each flag set, a
+// zigzag varint of the difference from the previous record:
+//   0x01  the PC, when it did not simply advance by one
+//   0x02  A
+//   0x04  D
+//   0x08  the written address, then the written value
+// A straight-line instruction that only changes D thus takes two bytes.
+//
+// The emulator only copies each record into a ring buffer; a background
+// thread encodes and writes them, so the run loop never waits on the disk
+// unless the buffer fills up.
+class TraceWriter
+{
+public:
+    TraceWriter(const std::string &filename);
+    ~TraceWriter();
+
+    // called by the emulator after every instruction
+    inline void record(uint16_t pc, uint16_t a, uint16_t d, bool write, uint16_t address, uint16_t value);
+
+    // drains the buffer and closes the file; the destructor does this too
+    void close();
+
+    TraceWriter(const TraceWriter &) = delete;
+    TraceWriter &operator=(const TraceWriter &) = delete;
+
+private:
+    struct Entry
+    {
+        uint16_t pc;
+        uint16_t a;
+        uint16_t d;
+        uint16_t address;
+        uint16_t value;
+        bool write;
+    };
+
+    static const size_t CAPACITY{1 << 16};
+
+    std::ofstream output;
+    std::vector<Entry> ring;
+
+    // a single producer and a single consumer; each side only advances its own index
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+    size_t freeUntil;
+    std::atomic<bool> done;
+    std::thread writer;
+
+    void drain();
+    void waitForSpace();
+};
+
+// Streams the records of a trace file back
+class TraceReader
+{
+public:
+    TraceReader(std::istream &input);
+    bool next(TraceRecord &record);
+
+private:
+    std::istream &input;
+    TraceRecord last;
+};
+
+// Writes a trace as lines of text, or as CSV with a header row
+void printTrace(TraceReader &reader, std::ostream &out, bool csv);
+
+inline void TraceWriter::record(uint16_t pc, uint16_t a, uint16_t d, bool write, uint16_t address, uint16_t value)
+{
+    size_t position = head.load(std::memory_order_relaxed);
+
+    if(position == freeUntil)
+        waitForSpace();
+
+    Entry &entry = ring[position & (CAPACITY - 1)];
+    entry.pc = pc;
+    entry.a = a;
+    entry.d = d;
+    entry.write = write;
+    entry.address = address;
+    entry.value = value;
+
+    head.store(position + 1, std::memory_order_release);
+}
+
+#endif // TRACE_H
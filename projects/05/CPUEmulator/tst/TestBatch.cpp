@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/Batch.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// ROM jobs with their own RAM share one program and report their results
+TEST(BatchTest, TestROMJobs_run)
+{
+    istringstream manifest(
+        "// max of R0 and R1 into R2\n"
+        "Max.asm set=0:3,1:9 expect=2:9 dump=0-2\n"
+        "Max.asm set=0:-4,1:-7 expect=2:-4\n"
+        "\n"
+        "Max.asm set=0:1,1:2 expect=2:1\n");
+    Batch batch(manifest, "TestScript", true);
+    ostringstream out;
+    batch.run(2, false, out);
+    ASSERT_EQ(batch.getFailures(), 1);
+
+    string json = out.str();
+    ASSERT_NE(json.find("\"passed\": true, \"halted\": true, \"cycles\": 12, \"ram\": {\"from\": 0, \"values\": [3, 9, 9]}"), string::npos);
+    ASSERT_NE(json.find("\"error\": \"RAM[2] is 2, expected 1\""), string::npos);
+}
+
+// script jobs pass when their comparison succeeds
+TEST(BatchTest, TestScriptJobs_run)
+{
+    istringstream manifest("Add.tst dump=0-0\nMissing.tst\n");
+    Batch batch(manifest, "TestScript", true);
+    ostringstream out;
+    batch.run(4, false, out);
+    ASSERT_EQ(batch.getFailures(), 1);
+    ASSERT_NE(out.str().find("\"values\": [5]"), string::npos);
+}
+
+// malformed lines are reported with their line number
+TEST(BatchTest, TestInvalidManifest_Batch)
+{
+    istringstream manifest("Max.asm set=0:3\nMax.asm set=0\n");
+    ASSERT_THROW(Batch(manifest, "", true), runtime_error);
+}
+
+// lockstep mode gives the same results as running each job on its own
+TEST(BatchTest, TestLockstep_run)
+{
+    string jobs =
+        "Max.asm set=0:3,1:9 expect=2:9 dump=0-2\n"
+        "Max.asm set=0:-4,1:-7 expect=2:-4\n"
+        "Max.asm set=0:1,1:2 expect=2:1\n"
+        "Add.tst\n";
+
+    istringstream single(jobs), grouped(jobs);
+    Batch expected(single, "TestScript", true), actual(grouped, "TestScript", true);
+    ostringstream expectedOut, actualOut;
+    expected.run(1, false, expectedOut);
+    actual.run(2, true, actualOut);
+
+    ASSERT_EQ(actual.getFailures(), 1);
+    ASSERT_EQ(actualOut.str(), expectedOut.str());
+}
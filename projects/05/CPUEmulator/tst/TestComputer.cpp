@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/Computer.h"
+#include "../src/Loader.h"
+
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+vector<uint16_t> assemble(const string &source)
+{
+    istringstream input(source);
+    return Loader::assemble(input);
+}
+
+// A-instruction loads A
+TEST(ComputerTest, TestAddress_step)
+{
+    Computer c;
+    c.load(assemble("@1234"));
+    c.step();
+    ASSERT_EQ(c.getA(), 1234);
+    ASSERT_EQ(c.getPC(), 1);
+    ASSERT_EQ(c.getCycles(), 1);
+}
+
+// M is written through the value A had before the instruction
+TEST(ComputerTest, TestOldAddress_step)
+{
+    Computer c;
+    c.load(assemble("@7\nD=A\nAM=D+1"));
+    c.run(3);
+    ASSERT_EQ(c.peek(7), 8);
+    ASSERT_EQ(c.getA(), 8);
+    ASSERT_EQ(c.getD(), 7);
+}
+
+// all 28 computations of the Hack ISA
+TEST(ComputerTest, TestALU_compute)
+{
+    uint16_t x = 17, y = 3;
+    
+    ASSERT_EQ(compute(0x2A, x, y), 0);
+    ASSERT_EQ(compute(0x3F, x, y), 1);
+    ASSERT_EQ(compute(0x3A, x, y), 0xFFFF);
+    ASSERT_EQ(compute(0x0C, x, y), x);
+    ASSERT_EQ(compute(0x30, x, y), y);
+    ASSERT_EQ(compute(0x0D, x, y), static_cast<uint16_t>(~x));
+    ASSERT_EQ(compute(0x31, x, y), static_cast<uint16_t>(~y));
+    ASSERT_EQ(compute(0x0F, x, y), static_cast<uint16_t>(-x));
+    ASSERT_EQ(compute(0x33, x, y), static_cast<uint16_t>(-y));
+    ASSERT_EQ(compute(0x1F, x, y), x + 1);
+    ASSERT_EQ(compute(0x37, x, y), y + 1);
+    ASSERT_EQ(compute(0x0E, x, y), x - 1);
+    ASSERT_EQ(compute(0x32, x, y), y - 1);
+    ASSERT_EQ(compute(0x02, x, y), x + y);
+    ASSERT_EQ(compute(0x13, x, y), x - y);
+    ASSERT_EQ(compute(0x07, x, y), static_cast<uint16_t>(y - x));
+    ASSERT_EQ(compute(0x00, x, y), x & y);
+    ASSERT_EQ(compute(0x15, x, y), x | y);
+}
+
+// jumps are taken on the ALU output and go to the old value of A
+TEST(ComputerTest, TestJump_step)
+{
+    Computer c;
+    c.load(assemble("@10\nD=-1;JLT\n@10\n0;JGT"));
+    c.run(2);
+    ASSERT_EQ(c.getPC(), 10);
+    
+    c.setPC(2);
+    c.run(2);
+    ASSERT_EQ(c.getPC(), 4);
+}
+
+// 16-bit arithmetic wraps around
+TEST(ComputerTest, TestOverflow_step)
+{
+    Computer c;
+    c.load(assemble("@32767\nD=A\nD=D+1"));
+    c.run(3);
+    ASSERT_EQ(static_cast<int16_t>(c.getD()), -32768);
+}
+
+// out of range addresses
+TEST(ComputerTest, TestOutOfRange_peek)
+{
+    Computer c;
+    ASSERT_THROW(c.peek(RAM_SIZE), runtime_error);
+    ASSERT_THROW(c.poke(-1, 0), runtime_error);
+}
+
+// labels and variables are resolved as by the assembler
+TEST(LoaderTest, TestSymbols_assemble)
+{
+    vector<uint16_t> program = assemble("(LOOP)\n@i\nM=M+1\n@j\n@LOOP\n0;JMP\n");
+    ASSERT_EQ(program.size(), 5);
+    ASSERT_EQ(program[0], 16);
+    ASSERT_EQ(program[1], 0xFDC8);
+    ASSERT_EQ(program[2], 17);
+    ASSERT_EQ(program[3], 0);
+    ASSERT_EQ(program[4], 0xEA87);
+}
+
+// the commutative forms written by the VM translator
+TEST(LoaderTest, TestCommutative_assemble)
+{
+    ASSERT_EQ(assemble("M=M+D")[0], assemble("M=D+M")[0]);
+    ASSERT_EQ(assemble("A=A+D")[0], assemble("A=D+A")[0]);
+    ASSERT_EQ(assemble("D=A-D")[0], 0xE1D0);
+}
+
+// blank lines and CRLF line endings
+TEST(LoaderTest, TestValid_readHack)
+{
+    istringstream input("0000000000000010\r\n\r\n1110110000010000\r\n");
+    vector<uint16_t> program = Loader::readHack(input);
+    ASSERT_EQ(program.size(), 2);
+    ASSERT_EQ(program[0], 2);
+    ASSERT_EQ(program[1], 0xEC10);
+}
+
+// not a binary word
+TEST(LoaderTest, TestInvalid_readHack)
+{
+    istringstream input("0000000000000010\n000000000000002\n");
+    ASSERT_THROW(Loader::readHack(input), runtime_error);
+}
+
+// the first bad line is reported, whether or not it has the length of a word
+TEST(LoaderTest, TestFirstError_readHack)
+{
+    for(string bad : {"000000000000000x", "00000000000000000", "0000 0000"})
+    {
+        istringstream input("1000000000000001\n  0111111111111110  \n" + bad + "\r\n10\n");
+        try
+        {
+            Loader::readHack(input);
+            FAIL();
+        }
+        catch(runtime_error &e)
+        {
+            ASSERT_EQ(string(e.what()), "Line 3: '" + bad + "' is not a 16-bit binary word");
+        }
+    }
+
+    istringstream input("1000000000000001\n  0111111111111110  \n0000000000000011");
+    ASSERT_EQ(Loader::readHack(input), (vector<uint16_t>{0x8001, 0x7FFE, 3}));
+}
+
+// (END) @END 0;JMP stops the run and keeps the cycle count at the halt
+TEST(ComputerTest, TestIdleLoop_isHalted)
+{
+    Computer c;
+    c.load(assemble("@5\nD=A\n@0\nM=D\n(END)\n@END\n0;JMP"));
+    c.run(1000000);
+    ASSERT_TRUE(c.isHalted());
+    ASSERT_EQ(c.getPC(), 4);
+    ASSERT_EQ(c.getCycles(), 4);
+    ASSERT_EQ(c.peek(0), 5);
+    
+    c.step();
+    ASSERT_EQ(c.getCycles(), 4);
+}
+
+// loops that write memory or registers, or poll it to exit, are not halts
+TEST(ComputerTest, TestBusyLoop_isHalted)
+{
+    Computer c;
+    c.load(assemble("(A)\n@i\nM=M+1\n@A\n0;JMP\n(B)\nD=D+1\n@B\n0;JMP\n(C)\n@KBD\nD=M\n@C\nD;JEQ"));
+    for(int pc : {0, 4, 7})
+    {
+        c.setPC(pc);
+        c.run(100);
+        ASSERT_FALSE(c.isHalted());
+    }
+}
+
+// a jump whose target was not loaded inside the loop can go anywhere
+TEST(ComputerTest, TestJumpOnly_isHalted)
+{
+    Computer c;
+    c.load(assemble("(L)\n@L\n0;JMP"));
+    c.setPC(1);
+    ASSERT_FALSE(c.isHalted());
+    c.setPC(0);
+    ASSERT_TRUE(c.isHalted());
+}
+
+// detection can be turned off
+TEST(ComputerTest, TestDisabled_setHaltDetection)
+{
+    Computer c;
+    c.setHaltDetection(false);
+    c.load(assemble("(END)\n@END\n0;JMP"));
+    c.run(10);
+    ASSERT_FALSE(c.isHalted());
+    ASSERT_EQ(c.getCycles(), 10);
+}
+
+// a breakpoint stops a run on arriving at its address, and the next run goes on from there
+TEST(ComputerTest, TestBreakpoint_run)
+{
+    Computer c;
+    c.load(assemble("(LOOP)\n@i\nM=M+1\n@LOOP\n0;JMP"));
+    c.setBreakpoint(2, true);
+
+    c.run(100);
+    ASSERT_EQ(c.getStop(), Stop::BREAKPOINT);
+    ASSERT_EQ(c.getStopAddress(), 2);
+    ASSERT_EQ(c.getCycles(), 2);
+
+    c.run(100);
+    ASSERT_EQ(c.getStop(), Stop::BREAKPOINT);
+    ASSERT_EQ(c.getCycles(), 6);
+    ASSERT_EQ(c.peek(16), 2);
+
+    c.setBreakpoint(2, false);
+    c.run(100);
+    ASSERT_EQ(c.getStop(), Stop::NONE);
+    ASSERT_EQ(c.getCycles(), 106);
+}
+
+// a watchpoint stops a run right after the instruction that writes its address
+TEST(ComputerTest, TestWatchpoint_run)
+{
+    Computer c;
+    c.load(assemble("@7\nD=A\n@20\nM=D\n@21\nM=D\n(END)\n@END\n0;JMP"));
+    c.setWatchpoint(21, true);
+
+    c.run(100);
+    ASSERT_EQ(c.getStop(), Stop::WATCHPOINT);
+    ASSERT_EQ(c.getStopAddress(), 21);
+    ASSERT_EQ(c.getCycles(), 6);
+    ASSERT_EQ(c.peek(21), 7);
+
+    c.run(100);
+    ASSERT_EQ(c.getStop(), Stop::HALT);
+    ASSERT_THROW(c.setWatchpoint(RAM_SIZE, true), runtime_error);
+}
+
+// the cycle limit counts every cycle since the load, stepped or run
+TEST(ComputerTest, TestLimit_setCycleLimit)
+{
+    Computer c;
+    c.load(assemble("(LOOP)\n@i\nM=M+1\n@LOOP\n0;JMP"));
+    c.setCycleLimit(10);
+
+    c.step();
+    c.run(5);
+    ASSERT_EQ(c.getStop(), Stop::NONE);
+    c.run(100);
+    ASSERT_EQ(c.getStop(), Stop::LIMIT);
+    ASSERT_EQ(c.getCycles(), 10);
+    c.step();
+    ASSERT_EQ(c.getCycles(), 10);
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/Computer.h"
+#include "../src/Display.h"
+#include "../src/Loader.h"
+#include "../src/Screen.h"
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// writes i to SCREEN + i % 8192, for ever
+static const string SCRIBBLE{
+    "(LOOP)\n"
+    "@i\n D=M\n @8191\n D=D&A\n @SCREEN\n D=D+A\n @address\n M=D\n"
+    "@i\n D=M\n @address\n A=M\n M=D\n"
+    "@i\n M=M+1\n @LOOP\n 0;JMP\n"
+};
+
+static vector<uint16_t> assembleDisplay(const string &source)
+{
+    istringstream input(source);
+    return Loader::assemble(input);
+}
+
+// whether the framebuffer shows what is on the screen of the computer
+static bool showsScreen(Screen &framebuffer, Computer &computer)
+{
+    Screen expected;
+    expected.touchAll();
+    expected.capture(computer.getRAM());
+
+    for(int y = 0; y < SCREEN_HEIGHT; y++)
+        for(int x = 0; x < SCREEN_WIDTH; x++)
+            if(framebuffer.isBlack(x, y) != expected.isBlack(x, y))
+                return false;
+
+    return true;
+}
+
+// A display whose renderer is stuck presenting until let go
+class StuckDisplay : public Display
+{
+public:
+    StuckDisplay() : Display(1000), stuck{true}, presented{0} {}
+
+    atomic<bool> stuck;
+    atomic<int> presented;
+
+protected:
+    void present(Screen &, uint64_t) override
+    {
+        while(stuck.load())
+            this_thread::yield();
+        presented++;
+    }
+};
+
+// the last frame shown is the screen as the run left it
+TEST(DisplayTest, TestFramebuffer)
+{
+    Computer computer;
+    unique_ptr<Display> display(new Display(1000));
+    computer.addMonitor(display.get());
+    computer.load(assembleDisplay(SCRIBBLE));
+
+    computer.run(2000000);
+    display->close(computer);
+
+    ASSERT_GE(display->getPublished(), 1);
+    ASSERT_LE(display->getRendered(), display->getPublished());
+    ASSERT_TRUE(showsScreen(display->getFramebuffer(), computer));
+}
+
+// the emulator keeps running, and publishing, while the renderer is busy
+TEST(DisplayTest, TestNeverBlocks)
+{
+    Computer computer;
+    unique_ptr<StuckDisplay> display(new StuckDisplay);
+    computer.addMonitor(display.get());
+    computer.load(assembleDisplay(SCRIBBLE));
+
+    computer.run(5000000);
+    ASSERT_EQ(computer.getCycles(), 5000000u);
+    ASSERT_EQ(display->presented.load(), 0);
+
+    display->stuck = false;
+    display->close(computer);
+
+    ASSERT_GE(display->presented.load(), 1);
+    ASSERT_TRUE(showsScreen(display->getFramebuffer(), computer));
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/HackMachine.h"
+
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+// Mult of project 4: RAM[2] = RAM[0] * RAM[1]
+const char *MULT{
+    "@2\nM=0\n"
+    "(LOOP)\n@1\nD=M\n@END\nD;JEQ\n@0\nD=M\n@2\nM=D+M\n@1\nM=M-1\n@LOOP\n0;JMP\n"
+    "(END)\n@END\n0;JMP\n"};
+
+TEST(HackMachineTest, TestRun_hack_run)
+{
+    hack_machine *machine = hack_create();
+    ASSERT_NE(machine, nullptr);
+    ASSERT_EQ(hack_version(), HACK_API_VERSION);
+
+    ASSERT_EQ(hack_load_asm(machine, MULT, strlen(MULT)), 0);
+
+    // many short runs on the same machine, as a harness would do them
+    for(uint16_t x = 0; x < 20; x++)
+    {
+        uint16_t operands[2] = {x, 7};
+        uint16_t product = 0;
+
+        hack_reset(machine);
+        ASSERT_EQ(hack_write_ram(machine, 0, operands, 2), 0);
+        ASSERT_EQ(hack_run(machine, 10000), HACK_STOP_HALT);
+        ASSERT_EQ(hack_peek(machine, 2, &product), 0);
+        ASSERT_EQ(product, x * 7);
+        ASSERT_TRUE(hack_is_halted(machine));
+    }
+
+    ASSERT_EQ(hack_get_pc(machine), 14);
+    ASSERT_EQ(hack_get_cycles(machine), 2 + 7 * 12 + 4u);
+
+    hack_destroy(machine);
+}
+
+TEST(HackMachineTest, TestConditions_hack_run)
+{
+    hack_machine *machine = hack_create();
+    const char *program = "0000000000000011\r\n1110110000010000\r\n0000000000000000\r\n1110001100001000\r\n";
+
+    ASSERT_EQ(hack_load_hack(machine, program, strlen(program)), 0);
+
+    ASSERT_EQ(hack_run(machine, 2), HACK_STOP_CYCLES);
+    ASSERT_EQ(hack_get_d(machine), 3);
+    ASSERT_EQ(hack_get_a(machine), 3);
+
+    ASSERT_EQ(hack_set_watchpoint(machine, 0, 1), 0);
+    ASSERT_EQ(hack_run(machine, 100), HACK_STOP_WATCHPOINT);
+    ASSERT_EQ(hack_stop_address(machine), 0);
+    ASSERT_EQ(hack_get_cycles(machine), 4u);
+
+    ASSERT_EQ(hack_set_watchpoint(machine, 0, 0), 0);
+    ASSERT_EQ(hack_set_breakpoint(machine, 2, 1), 0);
+    hack_reset(machine);
+    ASSERT_EQ(hack_run(machine, 100), HACK_STOP_BREAKPOINT);
+    ASSERT_EQ(hack_get_pc(machine), 2);
+
+    uint16_t ram[4];
+    ASSERT_EQ(hack_read_ram(machine, 0, ram, 4), 0);
+    ASSERT_EQ(ram[0], 3);
+    ASSERT_EQ(hack_clear_ram(machine), 0);
+    ASSERT_EQ(hack_read_ram(machine, 0, ram, 1), 0);
+    ASSERT_EQ(ram[0], 0);
+
+    hack_destroy(machine);
+}
+
+// errors come back as -1 and a message rather than as exceptions
+TEST(HackMachineTest, TestErrors_hack_last_error)
+{
+    hack_machine *machine = hack_create();
+    uint16_t value;
+
+    ASSERT_EQ(hack_peek(machine, 40000, &value), -1);
+    ASSERT_EQ(string(hack_last_error(machine)), "RAM address 40000 out of range");
+
+    ASSERT_EQ(hack_read_ram(machine, 32760, &value, 9), -1);
+    ASSERT_EQ(hack_set_breakpoint(machine, -1, 1), -1);
+
+    const char *bad = "0000000000000011\n2\n";
+    ASSERT_EQ(hack_load_hack(machine, bad, strlen(bad)), -1);
+    ASSERT_EQ(string(hack_last_error(machine)), "Line 2: '2' is not a 16-bit binary word");
+
+    const char *wrong = "D=Q\n";
+    ASSERT_EQ(hack_load_asm(machine, wrong, strlen(wrong)), -1);
+
+    hack_destroy(machine);
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/Computer.h"
+#include "../src/Heatmap.h"
+#include "../src/Loader.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+static vector<uint16_t> assembleHeatmap(const string &source)
+{
+    istringstream input(source);
+    return Loader::assemble(input);
+}
+
+// pushes 1 to 3 onto the stack ten times, then writes the keyboard once
+static const string PUSHES{
+    "@256\n D=A\n @SP\n M=D\n"
+    "@10\n D=A\n @R13\n M=D\n"
+    "(LOOP)\n"
+    "@256\n D=A\n @SP\n M=D\n"
+    "@3\n D=A\n @R14\n M=D\n"
+    "(PUSH)\n"
+    "@R14\n D=M\n @SP\n A=M\n M=D\n @SP\n M=M+1\n @R14\n MD=M-1\n @PUSH\n D;JGT\n"
+    "@R13\n MD=M-1\n @LOOP\n D;JGT\n"
+    "@KBD\n M=0\n"
+    "(END)\n @END\n 0;JMP\n"
+};
+
+// every access of M is counted, however many chunks the run takes
+TEST(HeatmapTest, TestCounts)
+{
+    Computer computer;
+    unique_ptr<Heatmap> heatmap(new Heatmap);
+    computer.setHeatmap(heatmap.get());
+    computer.load(assembleHeatmap(PUSHES));
+    computer.run(1000);
+
+    ASSERT_TRUE(computer.isHalted());
+
+    // three pushes of three words each, ten times
+    ASSERT_EQ(heatmap->getWrites(256), 10u);
+    ASSERT_EQ(heatmap->getWrites(258), 10u);
+    ASSERT_EQ(heatmap->getReads(256), 0u);
+    ASSERT_EQ(heatmap->getWrites(259), 0u);
+    ASSERT_EQ(heatmap->getStackHighWater(), 258);
+
+    // SP is set before the loop and each pass, and read, bumped and written by each push
+    ASSERT_EQ(heatmap->getWrites(0), 1u + 10 + 30);
+    ASSERT_EQ(heatmap->getReads(0), 60u);
+
+    // the counter is written once and read and written again each pass
+    ASSERT_EQ(heatmap->getReads(13), 10u);
+    ASSERT_EQ(heatmap->getWrites(13), 11u);
+    ASSERT_EQ(heatmap->getWrites(KBD_ADDRESS), 1u);
+
+    // the run loop gives the same counts one step at a time
+    Computer stepped;
+    unique_ptr<Heatmap> steppedHeatmap(new Heatmap);
+    stepped.setHeatmap(steppedHeatmap.get());
+    stepped.load(assembleHeatmap(PUSHES));
+    for(int i = 0; i < 1000; i++)
+        stepped.step();
+
+    for(int address : {0, 13, 14, 256, 257, 258, KBD_ADDRESS})
+    {
+        ASSERT_EQ(steppedHeatmap->getReads(address), heatmap->getReads(address));
+        ASSERT_EQ(steppedHeatmap->getWrites(address), heatmap->getWrites(address));
+    }
+}
+
+// the report totals each segment and warns of writes to the keyboard
+TEST(HeatmapTest, TestReport)
+{
+    Computer computer;
+    unique_ptr<Heatmap> heatmap(new Heatmap);
+    computer.setHeatmap(heatmap.get());
+    computer.load(assembleHeatmap(PUSHES));
+    computer.run(1000);
+
+    ostringstream report;
+    heatmap->report(report);
+
+    ASSERT_NE(report.str().find("stack     256-2047              3/1792               0              30"), string::npos) << report.str();
+    ASSERT_NE(report.str().find("Stack high-water mark: RAM[258], 3 words"), string::npos);
+    ASSERT_NE(report.str().find("Warning: 1 writes to keyboard address RAM[24576]"), string::npos);
+    ASSERT_EQ(report.str().find("overflowed"), string::npos);
+
+    ostringstream csv;
+    heatmap->writeCSV(csv);
+    ASSERT_EQ(csv.str().substr(0, csv.str().find('\n')), "address,reads,writes");
+    ASSERT_NE(csv.str().find("\n256,0,10\n"), string::npos);
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/Computer.h"
+#include "../src/Keyboard.h"
+#include "../src/Loader.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static vector<uint16_t> assembleKeyboard(const string &source)
+{
+    istringstream input(source);
+    return Loader::assemble(input);
+}
+
+// waits for a key, stores its code in RAM[1] and halts
+const string WAIT_FOR_KEY{"(WAIT)\n@KBD\nD=M\n@WAIT\nD;JEQ\n@1\nM=D\n(END)\n@END\n0;JMP"};
+
+TEST(KeyboardTest, TestKeys_code)
+{
+    ASSERT_EQ(KeyboardReplay::code("A"), 'A');
+    ASSERT_EQ(KeyboardReplay::code("7"), '7');
+    ASSERT_EQ(KeyboardReplay::code("space"), ' ');
+    ASSERT_EQ(KeyboardReplay::code("newline"), 128);
+    ASSERT_EQ(KeyboardReplay::code("UP"), 131);
+    ASSERT_EQ(KeyboardReplay::code("f12"), 152);
+    ASSERT_EQ(KeyboardReplay::code("65"), 65);
+    ASSERT_THROW(KeyboardReplay::code("shift"), runtime_error);
+}
+
+TEST(KeyboardTest, TestErrors_KeyboardReplay)
+{
+    istringstream unordered("200 press A\n100 release\n");
+    ASSERT_THROW(KeyboardReplay keys(unordered), runtime_error);
+
+    istringstream unknown("// a comment\n\n100 hold A\n");
+    try
+    {
+        KeyboardReplay keys(unknown);
+        FAIL();
+    }
+    catch(runtime_error &e)
+    {
+        ASSERT_EQ(string(e.what()).find("Line 3: "), 0u);
+    }
+
+    istringstream cycle("soon press A\n");
+    ASSERT_THROW(KeyboardReplay keys(cycle), runtime_error);
+}
+
+// keys go down and up on the cycles the script gives
+TEST(KeyboardTest, TestEvents_advance)
+{
+    Computer computer;
+    computer.load(assembleKeyboard("(LOOP)\n@KBD\nD=M\n@0\nM=D\n@LOOP\n0;JMP"));
+
+    istringstream script("10 press A   // the first key\n20 release\n20 press newline\n");
+    KeyboardReplay keys(script);
+    computer.addMonitor(&keys);
+
+    computer.run(9);
+    ASSERT_EQ(computer.peek(KBD_ADDRESS), 0);
+    computer.run(1);
+    ASSERT_EQ(computer.peek(KBD_ADDRESS), 'A');
+    ASSERT_EQ(keys.getPending(), 2u);
+    computer.run(10);
+    ASSERT_EQ(computer.peek(0), 'A');
+    ASSERT_EQ(computer.peek(KBD_ADDRESS), 128);
+    ASSERT_EQ(keys.getPending(), 0u);
+}
+
+TEST(KeyboardTest, TestIdle_getIdlePeriod)
+{
+    Computer computer;
+    computer.load(assembleKeyboard(WAIT_FOR_KEY));
+
+    computer.run(2);
+    ASSERT_EQ(computer.getIdlePeriod(), 4u);
+
+    // a pressed key gets the program out of the loop, and a halted one is not idle
+    computer.poke(KBD_ADDRESS, 'A');
+    ASSERT_EQ(computer.getIdlePeriod(), 0u);
+    computer.run(100);
+    ASSERT_TRUE(computer.isHalted());
+    ASSERT_EQ(computer.getIdlePeriod(), 0u);
+
+    // a loop may write RAM as long as it writes back what was there
+    computer.load(assembleKeyboard("(LOOP)\n@0\nM=0\n@LOOP\n0;JMP"));
+    computer.poke(0, 1);
+    ASSERT_EQ(computer.getIdlePeriod(), 0u);
+    computer.run(2);
+    ASSERT_EQ(computer.getIdlePeriod(), 4u);
+
+    computer.load(assembleKeyboard("(LOOP)\n@0\nM=M+1\n@LOOP\n0;JMP"));
+    ASSERT_EQ(computer.getIdlePeriod(), 0u);
+}
+
+// skipping through the wait ends in the same state as running through it
+TEST(KeyboardTest, TestSame_setFastForward)
+{
+    Computer computers[2];
+
+    for(int i = 0; i < 2; i++)
+    {
+        istringstream script("1000001 press Z\n");
+        KeyboardReplay keys(script);
+
+        computers[i].load(assembleKeyboard(WAIT_FOR_KEY));
+        computers[i].addMonitor(&keys);
+        computers[i].setFastForward(i == 1);
+        computers[i].run(3000000);
+        computers[i].removeMonitor(&keys);
+    }
+
+    ASSERT_TRUE(computers[0].isHalted());
+    ASSERT_TRUE(computers[1].isHalted());
+    ASSERT_EQ(computers[1].getCycles(), computers[0].getCycles());
+    ASSERT_EQ(computers[1].getPC(), computers[0].getPC());
+    ASSERT_EQ(computers[1].peek(1), 'Z');
+}
+
+// an idle wait is skipped in one go up to the next key, however far off
+TEST(KeyboardTest, TestDistant_setFastForward)
+{
+    Computer computer;
+    istringstream script("1000000000001 press Z\n");
+    KeyboardReplay keys(script);
+
+    computer.load(assembleKeyboard(WAIT_FOR_KEY));
+    computer.addMonitor(&keys);
+    computer.setFastForward(true);
+    computer.run(2000000000000);
+    computer.removeMonitor(&keys);
+
+    ASSERT_TRUE(computer.isHalted());
+    ASSERT_GT(computer.getCycles(), 1000000000001u);
+    ASSERT_EQ(computer.peek(1), 'Z');
+}
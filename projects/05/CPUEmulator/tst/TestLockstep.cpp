@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/Lockstep.h"
+#include "../src/Loader.h"
+
+#include <memory>
+#include <stdexcept>
+
+using namespace std;
+
+// Every lane ends as a Computer of its own would, however the lanes diverge
+static void compareWithComputer(const string &filename, const int16_t inputs[][2], int count, uint64_t cycles)
+{
+    shared_ptr<const Program> program = Computer::decode(Loader::load(filename), true);
+    Lockstep lanes(program, count);
+
+    for(int lane = 0; lane < count; lane++)
+    {
+        lanes.poke(lane, 0, static_cast<uint16_t>(inputs[lane][0]));
+        lanes.poke(lane, 1, static_cast<uint16_t>(inputs[lane][1]));
+    }
+
+    lanes.run(cycles);
+
+    for(int lane = 0; lane < count; lane++)
+    {
+        Computer computer;
+        computer.load(program);
+        computer.poke(0, static_cast<uint16_t>(inputs[lane][0]));
+        computer.poke(1, static_cast<uint16_t>(inputs[lane][1]));
+        computer.run(cycles);
+
+        ASSERT_EQ(lanes.isHalted(lane), computer.isHalted());
+        ASSERT_EQ(lanes.getCycles(lane), computer.getCycles());
+        ASSERT_EQ(lanes.getPC(lane), computer.getPC());
+        for(int address = 0; address < 24; address++)
+            ASSERT_EQ(lanes.peek(lane, address), computer.peek(address));
+    }
+}
+
+TEST(LockstepTest, TestMax_run)
+{
+    const int16_t inputs[][2] = {{3, 9}, {9, 3}, {-4, -7}, {0, 0}, {1, 2}};
+    compareWithComputer("TestScript/Max.asm", inputs, 5, 1000);
+}
+
+// loop counts differ between lanes, and some lanes run out of cycles
+TEST(LockstepTest, TestMult_run)
+{
+    const int16_t inputs[][2] = {{2, 3}, {7, 0}, {0, 5}, {6, 7}, {1, 100}, {3, 1}, {5, 5}, {9, 2},
+                                 {4, 4}, {12, 11}, {2, 40}, {8, 8}, {10, 3}, {1, 1}, {0, 0}, {6, 30}};
+    compareWithComputer("TestScript/Mult.asm", inputs, 16, 200);
+}
+
+// a second run continues where the first left off
+TEST(LockstepTest, TestResume_run)
+{
+    shared_ptr<const Program> program = Computer::decode(Loader::load("TestScript/Mult.asm"), true);
+    Lockstep lanes(program, 2);
+    lanes.poke(0, 1, 20);
+    lanes.poke(0, 0, 3);
+    lanes.poke(1, 1, 2);
+    lanes.poke(1, 0, 3);
+
+    lanes.run(100);
+    ASSERT_FALSE(lanes.isHalted(0));
+    ASSERT_TRUE(lanes.isHalted(1));
+
+    lanes.run(1000);
+    ASSERT_TRUE(lanes.isHalted(0));
+    ASSERT_EQ(lanes.peek(0, 2), 60);
+    ASSERT_EQ(lanes.peek(1, 2), 6);
+}
+
+TEST(LockstepTest, TestInvalidLanes_Lockstep)
+{
+    shared_ptr<const Program> program = Computer::decode(vector<uint16_t>(), true);
+    ASSERT_THROW(Lockstep(program, 0), runtime_error);
+    ASSERT_THROW(Lockstep(program, LANES + 1), runtime_error);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/Computer.h"
+#include "../src/Loader.h"
+#include "../src/Profiler.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+class ProfilerTest : public ::testing::Test
+{
+protected:
+    Computer computer;
+    Profiler profiler{true};
+    SourceMap map;
+
+    void SetUp() override
+    {
+        map = Loader::loadMap("TestScript/Functions.asm");
+        computer.load(Loader::load("TestScript/Functions.asm"));
+        computer.setProfiler(&profiler);
+        computer.run(1000);
+        ASSERT_TRUE(computer.isHalted());
+    }
+};
+
+TEST_F(ProfilerTest, TestCounts_record)
+{
+    ASSERT_EQ(map.size(), 18u);
+    ASSERT_EQ(map[2].line, 8);
+    ASSERT_EQ(map[2].label, "Main.main");
+    ASSERT_EQ(map[2].annotation, "push constant 3");
+    ASSERT_EQ(map[2].instruction, "@3");
+
+    ASSERT_EQ(profiler.getCount(0), 1u);
+    ASSERT_EQ(profiler.getCount(6), 3u);
+
+    // the loop jumps back twice, then falls through
+    ASSERT_EQ(profiler.getCount(11), 3u);
+    ASSERT_EQ(profiler.getTaken(11), 2u);
+}
+
+TEST_F(ProfilerTest, TestFunctions_report)
+{
+    ostringstream out;
+    profiler.report(out, map, 10);
+    string report = out.str();
+
+    // ret_0 and Main.main$LOOP belong to Main.main, which runs 4 + 3 * 2 + 3 * 4 instructions
+    ASSERT_NE(report.find("Main.main                                             22"), string::npos);
+    ASSERT_NE(report.find("Main.dec                                              12"), string::npos);
+    ASSERT_NE(report.find("ROM[11] line 21  D;JGT  // if-goto LOOP  taken 2, not taken 1"), string::npos);
+}
+
+TEST_F(ProfilerTest, TestCollapsed_writeCollapsed)
+{
+    ostringstream out;
+    profiler.writeCollapsed(out, map);
+
+    ASSERT_EQ(out.str(),
+        "(none);bootstrap code 2\n"
+        "Main.dec;sub 12\n"
+        "Main.main;call Main.dec 0 6\n"
+        "Main.main;if-goto LOOP 12\n"
+        "Main.main;push constant 3 4\n");
+}
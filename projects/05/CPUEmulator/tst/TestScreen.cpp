@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/Computer.h"
+#include "../src/Loader.h"
+#include "../src/Screen.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+static vector<uint16_t> assembleScreen(const string &source)
+{
+    istringstream input(source);
+    return Loader::assemble(input);
+}
+
+static string readFile(const string &filename)
+{
+    ifstream input(filename, ios::binary);
+    return string(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+}
+
+// the lowest bit of a word is its leftmost pixel, and only touched rows are looked at
+TEST(ScreenTest, TestPixels_capture)
+{
+    Computer computer;
+    unique_ptr<Screen> screen(new Screen);
+    computer.setScreen(screen.get());
+
+    ASSERT_FALSE(screen->capture(computer.getRAM()));
+
+    computer.poke(SCREEN_ADDRESS + 3 * SCREEN_ROW_WORDS + 1, 0x8001);
+    computer.poke(SCREEN_ADDRESS + 200 * SCREEN_ROW_WORDS, 0x0004);
+
+    ASSERT_TRUE(screen->capture(computer.getRAM()));
+    ASSERT_EQ(screen->getFirstChanged(), 3);
+    ASSERT_EQ(screen->getLastChanged(), 200);
+
+    ASSERT_TRUE(screen->isBlack(16, 3));
+    ASSERT_FALSE(screen->isBlack(17, 3));
+    ASSERT_TRUE(screen->isBlack(31, 3));
+    ASSERT_FALSE(screen->isBlack(32, 3));
+    ASSERT_TRUE(screen->isBlack(2, 200));
+    ASSERT_FALSE(screen->isBlack(2, 199));
+
+    // writing back the same pixels changes nothing
+    computer.poke(SCREEN_ADDRESS + 3 * SCREEN_ROW_WORDS + 1, 0x8001);
+    ASSERT_FALSE(screen->capture(computer.getRAM()));
+
+    // a program's stores are tracked as pokes are
+    computer.load(assembleScreen("@SCREEN\nD=A\n@100\nA=D+A\nM=-1\n@KBD\nM=1"));
+    computer.run(7);
+
+    ASSERT_TRUE(screen->capture(computer.getRAM()));
+    ASSERT_EQ(screen->getFirstChanged(), 3);
+    ASSERT_EQ(screen->getLastChanged(), 3);
+    ASSERT_TRUE(screen->isBlack(68, 3));
+}
+
+TEST(ScreenTest, TestImages_write)
+{
+    Computer computer;
+    unique_ptr<Screen> screen(new Screen);
+    computer.setScreen(screen.get());
+
+    computer.poke(SCREEN_ADDRESS, 0x0103);
+    screen->capture(computer.getRAM());
+
+    ostringstream pbm;
+    screen->writePBM(pbm);
+    string image = pbm.str();
+    string header{"P4\n512 256\n"};
+
+    ASSERT_EQ(image.size(), header.size() + SCREEN_WIDTH / 8 * SCREEN_HEIGHT);
+    ASSERT_EQ(image.compare(0, header.size(), header), 0);
+    ASSERT_EQ(static_cast<uint8_t>(image[header.size()]), 0xC0);
+    ASSERT_EQ(static_cast<uint8_t>(image[header.size() + 1]), 0x80);
+
+    ostringstream ppm;
+    screen->writePPM(ppm, 0, 1);
+    image = ppm.str();
+    header = "P6\n# rows 0-1\n512 2\n255\n";
+
+    ASSERT_EQ(image.size(), header.size() + SCREEN_WIDTH * 3 * 2);
+    ASSERT_EQ(image.compare(0, header.size(), header), 0);
+    ASSERT_EQ(static_cast<uint8_t>(image[header.size() + 3]), 0);
+    ASSERT_EQ(static_cast<uint8_t>(image[header.size() + 6]), 255);
+}
+
+// frames are only written when the screen changed, and diffs only hold the changed rows
+TEST(ScreenTest, TestFrames_advance)
+{
+    Computer computer;
+    unique_ptr<Screen> screen(new Screen);
+    FrameRecorder recorder(*screen, "Screen_out", 3, false, true);
+    computer.setScreen(screen.get());
+    computer.addMonitor(&recorder);
+
+    computer.load(assembleScreen("@SCREEN\nM=-1\n@SCREEN\nD=A\n@160\nA=D+A\nM=1\n(END)\n@END\n0;JMP"));
+    computer.run(100);
+    recorder.finish(computer);
+
+    ASSERT_TRUE(computer.isHalted());
+    ASSERT_EQ(recorder.getFrames(), 2);
+
+    string first = readFile("Screen_out_000000.pbm");
+    string second = readFile("Screen_out_000001.pbm");
+    remove("Screen_out_000000.pbm");
+    remove("Screen_out_000001.pbm");
+
+    ASSERT_EQ(first.compare(0, 11, "P4\n512 256\n"), 0);
+    ASSERT_EQ(static_cast<uint8_t>(first[11]), 0xFF);
+
+    string header{"P4\n# rows 5-5\n512 1\n"};
+    ASSERT_EQ(second.size(), header.size() + SCREEN_WIDTH / 8);
+    ASSERT_EQ(second.compare(0, header.size(), header), 0);
+    ASSERT_EQ(static_cast<uint8_t>(second[header.size()]), 0x80);
+}
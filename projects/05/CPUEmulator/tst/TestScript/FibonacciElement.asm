@@ -0,0 +1,476 @@
+	// bootstrap code
+	// SP = 256
+	@256
+	D=A
+	@SP
+	M=D
+	// call Sys.init
+	@ret_0
+	D=A
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@LCL
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@ARG
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@THIS
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@THAT
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@0
+	D=A
+	@5
+	D=A+D
+	@SP
+	D=M-D
+	@ARG
+	M=D
+	@SP
+	D=M
+	@LCL
+	M=D
+	@Sys.init
+	0;JMP
+(ret_0)
+
+// Sys.vm:
+	// function Sys.init 0
+(Sys.init)
+	// push constant 4
+	@4
+	D=A
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	// call Main.fibonacci 1
+	@ret_1
+	D=A
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@LCL
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@ARG
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@THIS
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@THAT
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@1
+	D=A
+	@5
+	D=A+D
+	@SP
+	D=M-D
+	@ARG
+	M=D
+	@SP
+	D=M
+	@LCL
+	M=D
+	@Main.fibonacci
+	0;JMP
+(ret_1)
+	// label WHILE
+(_$WHILE)
+	// goto WHILE
+	@_$WHILE
+	0;JMP
+
+// Main.vm:
+	// function Main.fibonacci 0
+(Main.fibonacci)
+	// push argument 0
+	@0
+	D=A
+	@ARG
+	A=M
+	A=A+D
+	D=M
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	// push constant 2
+	@2
+	D=A
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	// lt
+	@SP
+	A=M-1
+	D=M
+	A=A-1
+	D=M-D
+	@Main.vm$0T
+	D;JLT
+	@SP
+	A=M-1
+	A=A-1
+	M=0
+	@Main.vm$0E
+	0;JMP
+(Main.vm$0T)
+	@SP
+	A=M-1
+	A=A-1
+	M=-1
+(Main.vm$0E)
+	@SP
+	M=M-1
+	// if-goto IF_TRUE
+	@SP
+	A=M-1
+	D=M
+	@SP
+	M=M-1
+	@_$IF_TRUE
+	D;JNE
+	// goto IF_FALSE
+	@_$IF_FALSE
+	0;JMP
+	// label IF_TRUE
+(_$IF_TRUE)
+	// push argument 0
+	@0
+	D=A
+	@ARG
+	A=M
+	A=A+D
+	D=M
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	// return
+	@LCL
+	D=M
+	@R13
+	M=D
+	@R13
+	D=M
+	@5
+	A=D-A
+	D=M
+	@R14
+	M=D
+	@SP
+	A=M-1
+	D=M
+	@SP
+	M=M-1
+	@ARG
+	A=M
+	M=D
+	@ARG
+	D=M
+	D=D+1
+	@SP
+	M=D
+	@R13
+	D=M
+	@1
+	A=D-A
+	D=M
+	@THAT
+	M=D
+	@R13
+	D=M
+	@2
+	A=D-A
+	D=M
+	@THIS
+	M=D
+	@R13
+	D=M
+	@3
+	A=D-A
+	D=M
+	@ARG
+	M=D
+	@R13
+	D=M
+	@4
+	A=D-A
+	D=M
+	@LCL
+	M=D
+	@R14
+	A=M
+	0;JMP
+	// label IF_FALSE
+(_$IF_FALSE)
+	// push argument 0
+	@0
+	D=A
+	@ARG
+	A=M
+	A=A+D
+	D=M
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	// push constant 2
+	@2
+	D=A
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	// sub
+	@SP
+	A=M-1
+	D=M
+	A=A-1
+	M=M-D
+	@SP
+	M=M-1
+	// call Main.fibonacci 1
+	@ret_2
+	D=A
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@LCL
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@ARG
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@THIS
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@THAT
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@1
+	D=A
+	@5
+	D=A+D
+	@SP
+	D=M-D
+	@ARG
+	M=D
+	@SP
+	D=M
+	@LCL
+	M=D
+	@Main.fibonacci
+	0;JMP
+(ret_2)
+	// push argument 0
+	@0
+	D=A
+	@ARG
+	A=M
+	A=A+D
+	D=M
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	// push constant 1
+	@1
+	D=A
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	// sub
+	@SP
+	A=M-1
+	D=M
+	A=A-1
+	M=M-D
+	@SP
+	M=M-1
+	// call Main.fibonacci 1
+	@ret_3
+	D=A
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@LCL
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@ARG
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@THIS
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@THAT
+	D=M 
+	@SP
+	A=M
+	M=D
+	@SP
+	M=M+1
+	@1
+	D=A
+	@5
+	D=A+D
+	@SP
+	D=M-D
+	@ARG
+	M=D
+	@SP
+	D=M
+	@LCL
+	M=D
+	@Main.fibonacci
+	0;JMP
+(ret_3)
+	// add
+	@SP
+	A=M-1
+	D=M
+	A=A-1
+	M=M+D
+	@SP
+	M=M-1
+	// return
+	@LCL
+	D=M
+	@R13
+	M=D
+	@R13
+	D=M
+	@5
+	A=D-A
+	D=M
+	@R14
+	M=D
+	@SP
+	A=M-1
+	D=M
+	@SP
+	M=M-1
+	@ARG
+	A=M
+	M=D
+	@ARG
+	D=M
+	D=D+1
+	@SP
+	M=D
+	@R13
+	D=M
+	@1
+	A=D-A
+	D=M
+	@THAT
+	M=D
+	@R13
+	D=M
+	@2
+	A=D-A
+	D=M
+	@THIS
+	M=D
+	@R13
+	D=M
+	@3
+	A=D-A
+	D=M
+	@ARG
+	M=D
+	@R13
+	D=M
+	@4
+	A=D-A
+	D=M
+	@LCL
+	M=D
+	@R14
+	A=M
+	0;JMP
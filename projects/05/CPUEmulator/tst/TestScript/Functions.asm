@@ -0,0 +1,32 @@
+// Laid out as the VM translator lays out functions, with a loop calling Main.dec three times
+	// bootstrap code
+	@Main.main
+	0;JMP
+	// function Main.main 0
+(Main.main)
+	// push constant 3
+	@3
+	D=A
+	@R0
+	M=D
+(Main.main$LOOP)
+	// call Main.dec 0
+	@Main.dec
+	0;JMP
+(ret_0)
+	// if-goto LOOP
+	@R0
+	D=M
+	@Main.main$LOOP
+	D;JGT
+(Main.main$END)
+	// goto END
+	@Main.main$END
+	0;JMP
+	// function Main.dec 0
+(Main.dec)
+	// sub
+	@R0
+	M=M-1
+	@ret_0
+	0;JMP
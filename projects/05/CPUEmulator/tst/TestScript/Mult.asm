@@ -0,0 +1,23 @@
+// Computes R2 = R0 * R1 by repeated addition; the loop count varies with R1
+    @R2
+    M=0
+    @R1
+    D=M
+    @i
+    M=D
+(LOOP)
+    @i
+    D=M
+    @END
+    D;JLE
+    @R0
+    D=M
+    @R2
+    M=M+D
+    @i
+    M=M-1
+    @LOOP
+    0;JMP
+(END)
+    @END
+    0;JMP
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/Computer.h"
+#include "../src/Loader.h"
+#include "../src/Snapshot.h"
+#include "../src/TestScript.h"
+
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+class SnapshotTest : public ::testing::Test
+{
+protected:
+    const string filename{"Snapshot_out.snp"};
+    shared_ptr<const Program> program;
+    Computer warm;
+
+    // Mult half way through multiplying 7 by 300
+    void SetUp() override
+    {
+        program = Computer::decode(Loader::load("TestScript/Mult.asm"), true);
+        warm.load(program);
+        warm.poke(0, 7);
+        warm.poke(1, 300);
+        warm.run(1000);
+        Snapshot::save(warm, filename);
+    }
+
+    void TearDown() override
+    {
+        remove(filename.c_str());
+    }
+};
+
+// a restored computer carries on exactly where the saved one left off
+TEST_F(SnapshotTest, TestContinue_restore)
+{
+    Computer computer;
+    computer.load(program);
+    Snapshot::restore(computer, filename);
+
+    ASSERT_EQ(computer.getPC(), warm.getPC());
+    ASSERT_EQ(computer.getA(), warm.getA());
+    ASSERT_EQ(computer.getD(), warm.getD());
+    ASSERT_EQ(computer.getCycles(), 1000u);
+
+    warm.run(100000);
+    computer.run(100000);
+
+    ASSERT_TRUE(computer.isHalted());
+    ASSERT_EQ(computer.getCycles(), warm.getCycles());
+    ASSERT_EQ(computer.peek(2), 2100);
+}
+
+// computers restored from one snapshot do not see each other's writes, and the file is left alone
+TEST_F(SnapshotTest, TestCopyOnWrite_restore)
+{
+    Computer first, second;
+    first.load(program);
+    second.load(program);
+    Snapshot::restore(first, filename);
+    Snapshot::restore(second, filename);
+
+    // one more time round the loop
+    uint16_t left = second.peek(16);
+    first.poke(16, left + 1);
+    first.run(100000);
+    second.run(100000);
+
+    ASSERT_EQ(first.peek(2), 2107);
+    ASSERT_EQ(second.peek(2), 2100);
+
+    Computer third;
+    third.load(program);
+    Snapshot::restore(third, filename);
+    ASSERT_EQ(third.peek(1), 300);
+}
+
+TEST_F(SnapshotTest, TestOtherProgram_restore)
+{
+    Computer computer;
+    computer.load(Loader::load("TestScript/Max.asm"));
+    ASSERT_THROW(Snapshot::restore(computer, filename), runtime_error);
+    ASSERT_THROW(Snapshot::restore(computer, "TestScript/Mult.asm"), runtime_error);
+}
+
+// scripts can fork from a snapshot taken by another script
+TEST_F(SnapshotTest, TestScript_run)
+{
+    istringstream take("load Mult.asm, set RAM[0] 3, set RAM[1] 4, repeat 10 { ticktock; } save-snapshot ../Snapshot_out.snp;");
+    Computer computer;
+    TestScript(take, "TestScript", computer).run();
+
+    istringstream fork("load Mult.asm, load-snapshot ../Snapshot_out.snp, repeat { ticktock; }");
+    Computer forked;
+    TestScript(fork, "TestScript", forked).run();
+
+    computer.run(1000);
+
+    ASSERT_EQ(forked.peek(2), 12);
+    ASSERT_EQ(forked.getCycles(), computer.getCycles());
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/Computer.h"
+#include "../src/Loader.h"
+#include "../src/StackSampler.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+// The Fibonacci program of chapter 8, as the VM translator builds it: the
+// bootstrap code calls Sys.init, which calls Main.fibonacci recursively
+class StackSamplerTest : public ::testing::Test
+{
+protected:
+    Computer computer;
+    SourceMap map;
+
+    void SetUp() override
+    {
+        map = Loader::loadMap("TestScript/FibonacciElement.asm");
+        computer.load(Loader::load("TestScript/FibonacciElement.asm"));
+    }
+};
+
+TEST_F(StackSamplerTest, TestStacks_writeCollapsed)
+{
+    StackSampler sampler(1);
+    computer.addMonitor(&sampler);
+    computer.run(10000);
+
+    ASSERT_TRUE(computer.isHalted());
+    ASSERT_EQ(sampler.getSamples(), computer.getCycles());
+
+    ostringstream out;
+    sampler.writeCollapsed(out, map);
+    string stacks = out.str();
+
+    ASSERT_EQ(stacks.find("(none) "), 0u);
+    ASSERT_NE(stacks.find("\n(none);Sys.init "), string::npos);
+
+    // fibonacci(4) recurses down to fibonacci(1)
+    ASSERT_NE(stacks.find("\n(none);Sys.init;Main.fibonacci;Main.fibonacci;Main.fibonacci;Main.fibonacci "), string::npos);
+    ASSERT_EQ(stacks.find(";Main.fibonacci;Main.fibonacci;Main.fibonacci;Main.fibonacci;Main.fibonacci"), string::npos);
+}
+
+TEST_F(StackSamplerTest, TestTimes_report)
+{
+    StackSampler sampler(10);
+    computer.addMonitor(&sampler);
+
+    // stepping samples as running does
+    for(int i = 0; i < 500; i++)
+        computer.step();
+
+    ASSERT_EQ(sampler.getSamples(), 50u);
+
+    ostringstream out;
+    sampler.report(out, map);
+    string report = out.str();
+
+    ASSERT_EQ(report.find("50 samples, one every 10 cycles\n"), 0u);
+
+    // the bootstrap code is on every stack, and never below another function
+    ASSERT_NE(report.find("(none)                                               500  100.00%"), string::npos);
+    ASSERT_NE(report.find("Main.fibonacci"), string::npos);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/TestScript.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+string readFile(const string &filename)
+{
+    ifstream input(filename);
+    stringstream contents;
+    contents << input.rdbuf();
+    return contents.str();
+}
+
+// header and values are laid out as by the CPU emulator
+TEST(TestScriptTest, TestOutputFormat_run)
+{
+    istringstream input(
+        "load Add.asm, output-file Format.out,\n"
+        "output-list RAM[0]%D2.6.2 RAM[16]%D1.6.1 D%X1.4.1 A%B1.16.1;\n"
+        "repeat 6 { ticktock; }\n"
+        "output;\n");
+    Computer c;
+    TestScript script(input, "TestScript", c);
+    script.run();
+    ASSERT_EQ(readFile("TestScript/Format.out"),
+              "|  RAM[0]  |RAM[16] |  D   |        A         |\n"
+              "|       5  |      0 | 0005 | 0000000000000000 |\n");
+}
+
+// a program run against its compare file
+TEST(TestScriptTest, TestComparison_run)
+{
+    ifstream input("TestScript/Add.tst");
+    Computer c;
+    TestScript script(input, "TestScript", c);
+    script.run();
+    ASSERT_TRUE(script.hasComparison());
+}
+
+// '*' in the compare file matches anything; a mismatch stops the script
+TEST(TestScriptTest, TestComparisonFailure_run)
+{
+    istringstream input(
+        "load Add.asm, compare-to Wrong.cmp,\n"
+        "output-list RAM[0]%D2.6.2;\n"
+        "repeat 6 { ticktock; }\n"
+        "output;\n"
+        "set RAM[0] 7, output;\n");
+    Computer c;
+    TestScript script(input, "TestScript", c);
+    ASSERT_THROW(script.run(), runtime_error);
+    ASSERT_EQ(script.getLineNumber(), 5);
+}
+
+// set accepts decimal, hexadecimal and binary values
+TEST(TestScriptTest, TestValues_set)
+{
+    istringstream input("set RAM[1] -1, set RAM[2] %X7FFF, set D %B101, set PC 3;");
+    Computer c;
+    TestScript script(input, "", c);
+    script.run();
+    ASSERT_EQ(c.peek(1), 0xFFFF);
+    ASSERT_EQ(c.peek(2), 0x7FFF);
+    ASSERT_EQ(c.getD(), 5);
+    ASSERT_EQ(c.getPC(), 3);
+}
+
+// syntax errors report the line they are on
+TEST(TestScriptTest, TestSyntaxError_run)
+{
+    istringstream input("set RAM[1] 1,\n\nrepeat 3 {\n  ticktock;\n");
+    Computer c;
+    TestScript script(input, "", c);
+    ASSERT_THROW(script.run(), runtime_error);
+}
+
+// unsupported commands
+TEST(TestScriptTest, TestUnknownCommand_run)
+{
+    istringstream input("vmstep;");
+    Computer c;
+    TestScript script(input, "", c);
+    ASSERT_THROW(script.run(), runtime_error);
+}
+
+// an endless repeat ends when the program halts
+TEST(TestScriptTest, TestHalt_repeat)
+{
+    istringstream input("load Max.asm, set RAM[0] 3, set RAM[1] 9, repeat { ticktock; }");
+    Computer c;
+    TestScript script(input, "TestScript", c);
+    script.run();
+    ASSERT_TRUE(c.isHalted());
+    ASSERT_EQ(c.peek(2), 9);
+}
+
+// a breakpoint ends the script where it stopped the computer
+TEST(TestScriptTest, TestBreakpoint_isInterrupted)
+{
+    istringstream input(
+        "load Add.asm;\n"
+        "repeat { ticktock; }\n"
+        "set RAM[5] 1;\n");
+    Computer c;
+    c.setBreakpoint(3, true);
+    TestScript script(input, "TestScript", c);
+    script.run();
+    ASSERT_TRUE(script.isInterrupted());
+    ASSERT_EQ(c.getPC(), 3);
+    ASSERT_EQ(c.peek(5), 0);
+}
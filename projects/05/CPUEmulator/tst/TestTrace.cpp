@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/Computer.h"
+#include "../src/Loader.h"
+#include "../src/Trace.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+// A recorded run reads back as the same sequence of states, cycle by cycle
+TEST(TraceTest, TestRoundTrip_record)
+{
+    shared_ptr<const Program> program = Computer::decode(Loader::load("TestScript/Mult.asm"), true);
+    const string filename = "Trace_out.trc";
+
+    Computer traced;
+    traced.load(program);
+    traced.poke(0, 7);
+    traced.poke(1, 300);
+    {
+        TraceWriter trace(filename);
+        traced.setTrace(&trace);
+        traced.run(100000);
+        traced.setTrace(nullptr);
+    }
+    ASSERT_TRUE(traced.isHalted());
+
+    ifstream input(filename, ios::binary);
+    TraceReader reader(input);
+    TraceRecord record;
+
+    Computer computer;
+    computer.load(program);
+    computer.poke(0, 7);
+    computer.poke(1, 300);
+
+    while(reader.next(record))
+    {
+        uint16_t pc = computer.getPC();
+        uint16_t address = computer.getA() & 0x7FFF;
+        uint16_t before = computer.peek(address);
+        computer.step();
+
+        ASSERT_EQ(record.cycle, computer.getCycles());
+        ASSERT_EQ(record.pc, pc);
+        ASSERT_EQ(record.a, computer.getA());
+        ASSERT_EQ(record.d, computer.getD());
+        if(record.write)
+        {
+            ASSERT_EQ(record.address, address);
+            ASSERT_EQ(record.value, computer.peek(address));
+        }
+        else
+            ASSERT_EQ(before, computer.peek(address));
+    }
+
+    ASSERT_EQ(computer.getCycles(), traced.getCycles());
+    ASSERT_EQ(computer.peek(2), 2100);
+
+    // most instructions fit in two or three bytes
+    input.clear();
+    input.seekg(0, ios::end);
+    ASSERT_LT(static_cast<uint64_t>(input.tellg()), traced.getCycles() * 3);
+
+    input.close();
+    remove(filename.c_str());
+}
+
+TEST(TraceTest, TestPrint_printTrace)
+{
+    // @5 D=A M=D
+    istringstream trace(string("HACKTRC1") + '\x02' + '\x0A' + '\x04' + '\x0A' + '\x08' + '\x0A' + '\x0A');
+    TraceReader reader(trace);
+    ostringstream text;
+    printTrace(reader, text, true);
+
+    ASSERT_EQ(text.str(), "cycle,pc,a,d,address,value\n1,0,5,0,,\n2,1,5,5,,\n3,2,5,5,5,5\n");
+}
+
+TEST(TraceTest, TestInvalidTrace_TraceReader)
+{
+    istringstream notTrace("0000000000000000\n");
+    ASSERT_THROW(TraceReader reader(notTrace), runtime_error);
+
+    istringstream truncated(string("HACKTRC1") + '\x02');
+    TraceReader reader(truncated);
+    TraceRecord record;
+    ASSERT_THROW(reader.next(record), runtime_error);
+}
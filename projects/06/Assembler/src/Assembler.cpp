@@ -26,10 +26,10 @@
 /* Entry point and facade controller of the assembler
  */
 #include "Assembler.h"
-#include "Code.h"
-#include "Parser.h"
-#include "Utility.h"
+#include "Translator.h"
 
+#include <bitset>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -41,37 +41,36 @@
 
 using namespace std;
 
-Assembler::Assembler(const vector<string> &arguments)
+Assembler::Assembler(const vector<string> &arguments) : writeMap{false}
 {
     if(arguments.size() == 2)
         inputFile = arguments[1];
+    else if(arguments.size() == 3 && arguments[1] == "--map")
+    {
+        inputFile = arguments[2];
+        writeMap = true;
+    }
     else
-        throw runtime_error("1 argument is required.");
-
-    initializeSymbolTable();
+        throw runtime_error("Usage: Assembler [--map] <file.asm>");
 }
 
 void Assembler::run()
 {
     outputFile = parseFilename(inputFile) + ".hack";
-    
-    doFirstPass();
-    doSecondPass();
-}
 
-void Assembler::initializeSymbolTable()
-{
-    st.addEntry("SP", 0);
-    st.addEntry("LCL", 1);
-    st.addEntry("ARG", 2);
-    st.addEntry("THIS", 3);
-    st.addEntry("THAT", 4);
+    ifstream ifs(inputFile);
+    SourceMap map;
+    vector<uint16_t> program = Translator::assemble(ifs, writeMap ? &map : nullptr);
 
-    for (int i = 0; i < 16; i++)
-        st.addEntry("R" + to_string(i), i);
+    ofstream ofs(outputFile);
+    for(uint16_t word : program)
+        ofs << bitset<16>(word) << endl;
 
-    st.addEntry("SCREEN", 16384);
-    st.addEntry("KBD", 24576);
+    if(writeMap)
+    {
+        ofstream mapFile(parseFilename(inputFile) + ".map");
+        SourceMapFile::write(mapFile, map);
+    }
 }
 
 string Assembler::parseFilename(string filename)
@@ -88,136 +87,6 @@ string Assembler::parseFilename(string filename)
         throw runtime_error("Could not parse filename. Must end in .asm");
 }
 
-void Assembler::doFirstPass()
-{
-    // open file for reading
-    ifstream ifs(inputFile);
-    Parser parse(ifs);
-
-    int outputLineCounter = 0;
-
-    try
-    {
-        // while there are more commands
-        while (parse.hasMoreCommands())
-        {
-            // read the commands
-            parse.advance();
-
-            CommandType type = parse.getCommandType();
-
-            switch (type)
-            {
-            // if it's an L-command, add symbol to table
-            case CommandType::L:
-            {
-                string symbol = parse.getSymbol();
-                if (st.contains(symbol))
-                    throw runtime_error("Symbol '" + symbol + "is already defined.");
-                else
-                    st.addEntry(symbol, outputLineCounter);
-                continue;
-            }
-
-            // do nothing
-            case CommandType::A:
-            case CommandType::C:
-            {
-                outputLineCounter++;
-                break;
-            }
-
-            default:
-            {
-                throw runtime_error("Code converion error. Unknown why.");
-                break;
-            }
-            }
-        }
-
-    }
-    catch (runtime_error& e)
-    {
-        throw runtime_error("Line " + to_string(parse.getLineNumber()) + ": " + e.what());
-    }
-}
-
-void Assembler::doSecondPass()
-{
-    // open file for reading
-    ifstream ifs(inputFile);
-    Parser parse(ifs);
-    
-    // open file for writing
-    ofstream ofs(outputFile);
-
-    int storeRamAddress = 16;
-    
-    try
-    {
-        // while there are more commands
-        while(parse.hasMoreCommands())
-        {
-            // read the commands
-            parse.advance();
-            if (true)
-            {
-
-            }
-            CommandType type = parse.getCommandType();
-            
-            switch(type)
-            {
-                // skip the command if it's the L-type
-                case CommandType::L:
-                    break;
-                    
-                // if it's of the A-type, write the output
-                case CommandType::A:
-                {
-                    string symbol = parse.getSymbol();
-                    string address;
-
-                    if (isdigit(symbol[0]))
-                        address = symbol;
-                    else
-                    {
-                        if (!st.contains(symbol))
-                            st.addEntry(symbol, storeRamAddress++);
-                        address = to_string(st.GetAddress(symbol));
-                    }
-
-                    ofs << '0' << ntobs(address) << endl;
-                    break;
-                }
-                    
-                // if it's of the C-type, write the output
-                case CommandType::C:
-                {
-                    auto comp = Code::comp(parse.getComp());
-                    auto dest = Code::dest(parse.getDest());
-                    auto jump = Code::jump(parse.getJump());
-                    ofs << '1' << "11" << comp << dest  << jump << endl;
-                    break;
-                }
-                
-                default:
-                {
-                    throw runtime_error("Code converion error. Unknown why.");
-                    break;
-                }
-            }
-        }
-        
-    }
-    catch(runtime_error &e)
-    {
-        throw runtime_error("Line " + to_string(parse.getLineNumber()) + ": " + e.what());
-    }
-}
-
-
-
 int main(int argc, char *argv[])
 {
     // collect arguments passed to the program
@@ -230,9 +99,6 @@ int main(int argc, char *argv[])
     
     try
     {
-        // initialize code module
-        Code::init();
-    
         // pass them to the assembler
         Assembler program(arguments);
         program.run();
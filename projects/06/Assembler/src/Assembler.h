@@ -32,8 +32,6 @@
 #include <vector>
 #include <string>
 
-#include "SymbolTable.h"
-
 class Assembler
 {
 public:
@@ -47,13 +45,12 @@ public:
 private:
     
     std::string parseFilename(std::string);
-    void initializeSymbolTable();
-    void doFirstPass();
-    void doSecondPass();
     
     std::string inputFile;
     std::string outputFile;
-    SymbolTable st;
+    
+    // with --map, the source of every ROM address is written next to the .hack file
+    bool writeMap;
 };
 
 #endif // ASSEMBLER_H
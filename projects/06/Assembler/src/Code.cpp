@@ -33,84 +33,104 @@
 
 using namespace std;
 
-static unordered_map<string, string> destMap;
-static unordered_map<string, string> compMap;
-static unordered_map<string, string> jumpMap;
+typedef unordered_map<string, string> Table;
 
-void Code::init()
+// The tables are built once, on first use; C++11 makes that safe when
+// several threads assemble at once
+static const Table &destMap()
 {
-    // initialize dest map
-    destMap[""] = "000";
-    destMap["M"] = "001";
-    destMap["D"] = "010";
-    destMap["MD"] = "011";
-    destMap["A"] = "100";
-    destMap["AM"] = "101";
-    destMap["AD"] = "110";
-    destMap["AMD"] = "111";
-    
-    // initialize comp map
-    compMap["0"] = "0101010";
-    compMap["1"] = "0111111";
-    compMap["-1"] = "0111010";
-    compMap["D"] = "0001100";
-    compMap["A"] = "0110000";
-    compMap["!D"] = "0001101";
-    compMap["!A"] = "0110001";
-    compMap["-D"] = "0001111";
-    compMap["-A"] = "0110011";
-    compMap["D+1"] = "0011111";
-    compMap["A+1"] = "0110111";
-    compMap["D-1"] = "0001110";
-    compMap["A-1"] = "0110010";
-    compMap["D+A"] = "0000010";
-    compMap["D-A"] = "0010011";
-    compMap["A-D"] = "00000111";
-    compMap["D&A"] = "0000000";
-    compMap["D|A"] = "0010101";
-    compMap["M"] = "1110000";
-    compMap["!M"] = "1110001";
-    compMap["-M"] = "1110011";
-    compMap["M+1"] = "1110111";
-    compMap["M-1"] = "1110010";
-    compMap["D+M"] = "1000010";
-    compMap["D-M"] = "1010011";
-    compMap["M-D"] = "1000111";
-    compMap["D&M"] = "1000000";
-    compMap["D|M"] = "1010101";
-    
-    // initialize jump map
-    jumpMap[""] = "000";
-    jumpMap["JGT"] = "001";
-    jumpMap["JEQ"] = "010";
-    jumpMap["JGE"] = "011";
-    jumpMap["JLT"] = "100";
-    jumpMap["JNE"] = "101";
-    jumpMap["JLE"] = "110";
-    jumpMap["JMP"] = "111";
+    static const Table map{
+        {"", "000"},
+        {"M", "001"},
+        {"D", "010"},
+        {"MD", "011"},
+        {"A", "100"},
+        {"AM", "101"},
+        {"AD", "110"},
+        {"AMD", "111"}
+    };
+    return map;
+}
+
+static const Table &compMap()
+{
+    static const Table map{
+        {"0", "0101010"},
+        {"1", "0111111"},
+        {"-1", "0111010"},
+        {"D", "0001100"},
+        {"A", "0110000"},
+        {"!D", "0001101"},
+        {"!A", "0110001"},
+        {"-D", "0001111"},
+        {"-A", "0110011"},
+        {"D+1", "0011111"},
+        {"A+1", "0110111"},
+        {"D-1", "0001110"},
+        {"A-1", "0110010"},
+        {"D+A", "0000010"},
+        {"D-A", "0010011"},
+        {"A-D", "0000111"},
+        {"D&A", "0000000"},
+        {"D|A", "0010101"},
+        {"M", "1110000"},
+        {"!M", "1110001"},
+        {"-M", "1110011"},
+        {"M+1", "1110111"},
+        {"M-1", "1110010"},
+        {"D+M", "1000010"},
+        {"D-M", "1010011"},
+        {"M-D", "1000111"},
+        {"D&M", "1000000"},
+        {"D|M", "1010101"},
+        
+        // commutative forms, as emitted by the VM translator
+        {"A+D", "0000010"},
+        {"A&D", "0000000"},
+        {"A|D", "0010101"},
+        {"M+D", "1000010"},
+        {"M&D", "1000000"},
+        {"M|D", "1010101"}
+    };
+    return map;
+}
+
+static const Table &jumpMap()
+{
+    static const Table map{
+        {"", "000"},
+        {"JGT", "001"},
+        {"JEQ", "010"},
+        {"JGE", "011"},
+        {"JLT", "100"},
+        {"JNE", "101"},
+        {"JLE", "110"},
+        {"JMP", "111"}
+    };
+    return map;
 }
 
-string translate(const string &s, unordered_map<string, string> &map)
+static string translate(const string &s, const Table &map)
 {
     auto in = map.find(s);
     
     if(in == map.end())
         throw runtime_error("Could not translate '" + s + "'. Invalid option.");
     else
-        return map[s];
+        return in->second;
 }
 
 string Code::dest(const string &s)
 {
-    return translate(s, destMap);
+    return translate(s, destMap());
 }
 
 string Code::comp(const string &s)
 {
-    return translate(s, compMap);
+    return translate(s, compMap());
 }
 
 string Code::jump(const string &s)
 {
-    return translate(s, jumpMap);
+    return translate(s, jumpMap());
 }
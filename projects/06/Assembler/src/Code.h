@@ -34,7 +34,6 @@
 // Refer to the API documentation in chapter 6
 namespace Code
 {
-    void init();
     std::string dest(const std::string &mnemonic);
     std::string comp(const std::string &mnemonic);
     std::string jump(const std::string &mnemonic);
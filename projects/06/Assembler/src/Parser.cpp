@@ -114,6 +114,11 @@ int Parser::getLineNumber()
     return line_no;
 }
 
+std::string Parser::getComment()
+{
+    return comment;
+}
+
 
 void Parser::skipComments()
 {
@@ -140,6 +145,7 @@ void Parser::skipComments()
         if(ch == '/' && input.peek() == '/') 
         {
             getline(input, ignore);
+            comment = trim(ignore.substr(1));
             line_no++;
         }
         
@@ -54,6 +54,10 @@ public:
     std::string getJump();
     int getLineNumber();
     
+    // the text of the last whole-line comment read, such as the VM command
+    // the translator annotates its output with
+    std::string getComment();
+    
 private:
     std::istream &input;
     CommandType type;
@@ -62,6 +66,7 @@ private:
     std::string dest;
     std::string comp;
     std::string jump;
+    std::string comment;
     
     void skipComments();
     void parseLabel(const std::string &s);
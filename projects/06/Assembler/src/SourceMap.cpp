@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the SourceMap module.
+ */
+
+#include "SourceMap.h"
+
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+void SourceMapFile::write(ostream &output, const SourceMap &map)
+{
+    for(size_t address = 0; address < map.size(); address++)
+    {
+        const SourceLine &source = map[address];
+        
+        output << address << '\t' << source.line << '\t' << source.label << '\t'
+               << source.annotation << '\t' << source.instruction << '\n';
+    }
+}
+
+SourceMap SourceMapFile::read(istream &input)
+{
+    SourceMap map;
+    string line;
+    
+    while(getline(input, line))
+    {
+        if(line.empty())
+            continue;
+        
+        vector<string> fields;
+        istringstream stream(line);
+        string field;
+        
+        while(getline(stream, field, '\t'))
+            fields.push_back(field);
+        
+        if(fields.size() == 4)
+            fields.push_back("");
+        
+        try
+        {
+            if(fields.size() != 5 || stoul(fields[0]) != map.size())
+                throw invalid_argument(line);
+            
+            map.push_back(SourceLine{stoi(fields[1]), fields[2], fields[3], fields[4]});
+        }
+        catch(logic_error &e)
+        {
+            throw runtime_error("Map entry " + to_string(map.size()) + " is malformed");
+        }
+    }
+    
+    return map;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the SourceMap module.
+ */
+
+#ifndef SOURCE_MAP_H
+#define SOURCE_MAP_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Where the instruction at one ROM address came from
+struct SourceLine
+{
+    int line;                   // line number in the .asm file
+    std::string label;          // the last label declared before it
+    std::string annotation;     // the last whole-line comment before it
+    std::string instruction;    // the instruction as written, without whitespace
+};
+
+// Indexed by ROM address
+typedef std::vector<SourceLine> SourceMap;
+
+// A .map file has one tab-separated line per ROM address:
+//   address, line, label, annotation, instruction
+namespace SourceMapFile
+{
+    void write(std::ostream &output, const SourceMap &map);
+    SourceMap read(std::istream &input);
+};
+
+#endif // SOURCE_MAP_H
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Translator module.
+ */
+
+#include "Translator.h"
+#include "Code.h"
+#include "Parser.h"
+#include "SymbolTable.h"
+
+#include <bitset>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+const int VARIABLE_BASE{16};
+
+static void initializeSymbolTable(SymbolTable &st)
+{
+    st.addEntry("SP", 0);
+    st.addEntry("LCL", 1);
+    st.addEntry("ARG", 2);
+    st.addEntry("THIS", 3);
+    st.addEntry("THAT", 4);
+
+    for(int i = 0; i < 16; i++)
+        st.addEntry("R" + to_string(i), i);
+
+    st.addEntry("SCREEN", 16384);
+    st.addEntry("KBD", 24576);
+}
+
+// The C-instruction as written, without whitespace
+static string instruction(Parser &parse)
+{
+    string text = parse.getComp();
+
+    if(!parse.getDest().empty())
+        text = parse.getDest() + "=" + text;
+    if(!parse.getJump().empty())
+        text += ";" + parse.getJump();
+
+    return text;
+}
+
+static void doFirstPass(istream &source, SymbolTable &st)
+{
+    Parser parse(source);
+    int counter = 0;
+
+    try
+    {
+        while(parse.hasMoreCommands())
+        {
+            parse.advance();
+
+            if(parse.getCommandType() == CommandType::L)
+            {
+                string symbol = parse.getSymbol();
+                if(st.contains(symbol))
+                    throw runtime_error("Symbol '" + symbol + "' is already defined.");
+                st.addEntry(symbol, counter);
+            }
+            else
+                counter++;
+        }
+    }
+    catch(runtime_error &e)
+    {
+        throw runtime_error("Line " + to_string(parse.getLineNumber()) + ": " + e.what());
+    }
+}
+
+static vector<uint16_t> doSecondPass(istream &source, SymbolTable &st, SourceMap *map)
+{
+    vector<uint16_t> program;
+    Parser parse(source);
+    int variable = VARIABLE_BASE;
+    string label;
+
+    try
+    {
+        while(parse.hasMoreCommands())
+        {
+            int line = parse.getLineNumber();
+
+            parse.advance();
+
+            switch(parse.getCommandType())
+            {
+                case CommandType::L:
+                    label = parse.getSymbol();
+                    break;
+
+                case CommandType::A:
+                {
+                    string symbol = parse.getSymbol();
+                    int address;
+
+                    if(isdigit(symbol[0]))
+                        address = stoi(symbol);
+                    else
+                    {
+                        if(!st.contains(symbol))
+                            st.addEntry(symbol, variable++);
+                        address = st.GetAddress(symbol);
+                    }
+
+                    if(address < 0 || address > 32767)
+                        throw runtime_error("Address '" + symbol + "' does not fit in 15 bits.");
+
+                    program.push_back(static_cast<uint16_t>(address));
+                    if(map)
+                        map->push_back(SourceLine{line, label, parse.getComment(), "@" + symbol});
+                    break;
+                }
+
+                case CommandType::C:
+                {
+                    string bits = "111" + Code::comp(parse.getComp()) + Code::dest(parse.getDest()) + Code::jump(parse.getJump());
+                    program.push_back(static_cast<uint16_t>(bitset<16>(bits).to_ulong()));
+                    if(map)
+                        map->push_back(SourceLine{line, label, parse.getComment(), instruction(parse)});
+                    break;
+                }
+
+                default:
+                    throw runtime_error("Code converion error. Unknown why.");
+            }
+        }
+    }
+    catch(runtime_error &e)
+    {
+        throw runtime_error("Line " + to_string(parse.getLineNumber()) + ": " + e.what());
+    }
+
+    return program;
+}
+
+vector<uint16_t> Translator::assemble(istream &input, SourceMap *map)
+{
+    SymbolTable st;
+    initializeSymbolTable(st);
+
+    // the parser reads the source twice, so keep a copy of it
+    stringstream source;
+    source << input.rdbuf();
+
+    doFirstPass(source, st);
+
+    source.clear();
+    source.seekg(0);
+
+    return doSecondPass(source, st, map);
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Translator module.
+ */
+
+#ifndef TRANSLATOR_H
+#define TRANSLATOR_H
+
+#include "SourceMap.h"
+
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+// The two passes of chapter 6, shared by the assembler and the emulator of
+// chapter 5: the first binds labels to ROM addresses, the second translates
+// every instruction and allocates variables from RAM[16] on as they appear
+namespace Translator
+{
+    // the machine words of a program, with the source of each in map if given
+    std::vector<uint16_t> assemble(std::istream &input, SourceMap *map = nullptr);
+};
+
+#endif // TRANSLATOR_H
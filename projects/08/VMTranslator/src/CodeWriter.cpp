@@ -28,6 +28,7 @@
 
 #include "CodeWriter.h"
 
+#include <algorithm>
 #include <stdexcept>
 #include <cassert>
 
@@ -39,7 +40,20 @@ const int TEMP_SIZE{8};
 const int POINTER_SIZE{2};
 const int BOOTSTRAP_SP{256};
 
-CodeWriter::CodeWriter(ostream& outputStream) : out{outputStream}
+// The highest index stored into through a pointer segment by stepping A from
+// its base; higher ones go through an address kept in R13
+const int STORE_STEPS{4};
+
+// The shared call and return routines
+const string CALL_ROUTINE{"$call"};
+const string RETURN_ROUTINE{"$return"};
+
+// The shared comparison routines, for eq, gt and lt, and the jumps that make them true
+const string COMPARISON_ROUTINES[]{"$eq", "$gt", "$lt"};
+const string COMPARISON_JUMPS[]{"JEQ", "JGT", "JLT"};
+const string NEGATED_JUMPS[]{"JNE", "JLE", "JGE"};
+
+CodeWriter::CodeWriter(ostream& outputStream) : out{outputStream}, branchCount{0}, returnCount{0}, peephole{false}, rewrites{0}, trampolines{false}, callUsed{false}, returnUsed{false}, sharedComparisons{false}, comparisonUsed{}, stackCaching{false}, cached{false}
 {
     setFunctionName("_");
 }
@@ -57,6 +71,9 @@ void CodeWriter::setFilename(string filename)
     else
         throw runtime_error("File prefix in '" + filename + "' not found");
 	
+	// the previous file leaves its stack in memory
+	writeSpill();
+	
 	branchCount = 0;
 
 	out << endl << "// " << filename << ":" << endl;
@@ -75,7 +92,7 @@ void CodeWriter::writeInit()
 
 }
 
-void CodeWriter::writeLabel(string label)
+void CodeWriter::writeLabel(const string &label)
 {
     assert(label.length() > 0);
     assert(function_name.length() > 0);
@@ -83,7 +100,7 @@ void CodeWriter::writeLabel(string label)
     out << "(" << function_name << "$" << label << ")" << endl;
 }
 
-void CodeWriter::writeGoto(string label)
+void CodeWriter::writeGoto(const string &label)
 {
     assert(label.length() > 0);
     assert(function_name.length() > 0);
@@ -93,7 +110,7 @@ void CodeWriter::writeGoto(string label)
         << "\t0;JMP\n";
 }
 
-void CodeWriter::writeIf(string label)
+void CodeWriter::writeIf(const string &label)
 {
     assert(label.length() > 0);
     assert(function_name.length() > 0);
@@ -108,7 +125,7 @@ void CodeWriter::writeIf(string label)
         << "\tD;JNE\n";
 }
 
-void CodeWriter::writeCall(string functionName, int numArgs)
+void CodeWriter::writeCall(const string &functionName, int numArgs)
 {
     assert(functionName.length() > 0);
     
@@ -117,6 +134,35 @@ void CodeWriter::writeCall(string functionName, int numArgs)
     
     string returnLabel = nextReturnLabel();
     
+    if(trampolines)
+    {
+        // R14 = n, R13 = f, D = return-address, goto the call routine
+        if(numArgs <= 1)
+            out <<
+                "\t@R14\n"
+                "\tM=" << numArgs << "\n";
+        else
+            out <<
+                "\t@" << numArgs << "\n"
+                "\tD=A\n"
+                "\t@R14\n"
+                "\tM=D\n";
+        
+        out <<
+            "\t@" << functionName << "\n"
+            "\tD=A\n"
+            "\t@R13\n"
+            "\tM=D\n"
+            "\t@" << returnLabel << "\n"
+            "\tD=A\n"
+            "\t@" << CALL_ROUTINE << "\n"
+            "\t0;JMP\n"
+            "(" << returnLabel << ")\n";
+        
+        callUsed = true;
+        return;
+    }
+    
     out <<
             // push return-address
             "\t@" << returnLabel << endl <<
@@ -187,24 +233,37 @@ void CodeWriter::writeCall(string functionName, int numArgs)
             "(" << returnLabel << ")\n";
 }
 
-void CodeWriter::writeFunction(std::string functionName, int numArgs)
+void CodeWriter::writeFunction(const string &functionName, int numArgs)
 {
     assert(functionName.length() > 0);
     
     if(numArgs < 0)
         throw runtime_error("Call command: Number of arguments must be positive");
     
+    // labels inside are scoped to the function
+    setFunctionName(functionName);
+    
     //(f)
     out << "(" << functionName << ")" << endl;
     
     // repeat k times:
     // push 0
     for(int k = 0; k < numArgs; k++)
-        writePushPop(CommandType::Push, "constant", 0);
+        writePushPop(Opcode::Push, Segment::Constant, 0);
 }
 
 void CodeWriter::writeReturn()
 {
+    if(trampolines)
+    {
+        out <<
+            "\t@" << RETURN_ROUTINE << "\n"
+            "\t0;JMP\n";
+        
+        returnUsed = true;
+        return;
+    }
+    
     out <<
             // FRAME = LCL
             "\t@LCL\n"
@@ -280,9 +339,189 @@ void CodeWriter::writeReturn()
             "\t0;JMP\n";
 }
 
-void CodeWriter::writeArithmetic(string command)
+void CodeWriter::setTrampolines(bool enabled)
 {
-	if(command == "add")
+    trampolines = enabled;
+}
+
+void CodeWriter::setSharedComparisons(bool enabled)
+{
+    sharedComparisons = enabled;
+}
+
+void CodeWriter::setStackCaching(bool enabled)
+{
+    stackCaching = enabled;
+}
+
+void CodeWriter::writeSubroutines()
+{
+    writeSpill();
+    
+    bool used = callUsed || returnUsed || comparisonUsed[0] || comparisonUsed[1] || comparisonUsed[2];
+    
+    // a program without the bootstrap runs off its last command; stop it there
+    if(used)
+        out << endl <<
+            "($end)\n"
+            "\t@$end\n"
+            "\t0;JMP\n";
+    
+    if(callUsed)
+    {
+        out << endl << "// shared call routine: D = return-address, R13 = f, R14 = n" << endl;
+        out <<
+            "(" << CALL_ROUTINE << ")\n"
+            
+            // push return-address
+            "\t@SP\n"
+            "\tA=M\n"
+            "\tM=D\n"
+            
+            // push LCL, ARG, THIS and THAT
+            "\t@LCL\n"
+            "\tD=M\n"
+            "\t@SP\n"
+            "\tAM=M+1\n"
+            "\tM=D\n"
+            "\t@ARG\n"
+            "\tD=M\n"
+            "\t@SP\n"
+            "\tAM=M+1\n"
+            "\tM=D\n"
+            "\t@THIS\n"
+            "\tD=M\n"
+            "\t@SP\n"
+            "\tAM=M+1\n"
+            "\tM=D\n"
+            "\t@THAT\n"
+            "\tD=M\n"
+            "\t@SP\n"
+            "\tAM=M+1\n"
+            "\tM=D\n"
+            
+            // LCL = SP = SP+5
+            "\t@SP\n"
+            "\tMD=M+1\n"
+            "\t@LCL\n"
+            "\tM=D\n"
+            
+            // ARG = SP-n-5
+            "\t@R14\n"
+            "\tD=D-M\n"
+            "\t@5\n"
+            "\tD=D-A\n"
+            "\t@ARG\n"
+            "\tM=D\n"
+            
+            // goto f
+            "\t@R13\n"
+            "\tA=M\n"
+            "\t0;JMP\n";
+    }
+    
+    if(returnUsed)
+    {
+        out << endl << "// shared return routine" << endl;
+        out <<
+            "(" << RETURN_ROUTINE << ")\n"
+            
+            // FRAME = LCL
+            "\t@LCL\n"
+            "\tD=M\n"
+            "\t@R13\n"
+            "\tM=D\n"
+            
+            // RET = *(FRAME-5)
+            "\t@5\n"
+            "\tA=D-A\n"
+            "\tD=M\n"
+            "\t@R14\n"
+            "\tM=D\n"
+            
+            // *ARG = pop()
+            "\t@SP\n"
+            "\tAM=M-1\n"
+            "\tD=M\n"
+            "\t@ARG\n"
+            "\tA=M\n"
+            "\tM=D\n"
+            
+            // SP = ARG+1
+            "\t@ARG\n"
+            "\tD=M+1\n"
+            "\t@SP\n"
+            "\tM=D\n"
+            
+            // THAT, THIS, ARG, LCL = *(FRAME-1) to *(FRAME-4)
+            "\t@R13\n"
+            "\tAM=M-1\n"
+            "\tD=M\n"
+            "\t@THAT\n"
+            "\tM=D\n"
+            "\t@R13\n"
+            "\tAM=M-1\n"
+            "\tD=M\n"
+            "\t@THIS\n"
+            "\tM=D\n"
+            "\t@R13\n"
+            "\tAM=M-1\n"
+            "\tD=M\n"
+            "\t@ARG\n"
+            "\tM=D\n"
+            "\t@R13\n"
+            "\tAM=M-1\n"
+            "\tD=M\n"
+            "\t@LCL\n"
+            "\tM=D\n"
+            
+            // goto RET
+            "\t@R14\n"
+            "\tA=M\n"
+            "\t0;JMP\n";
+    }
+    
+    for(int comparison = 0; comparison < 3; comparison++)
+    {
+        if(!comparisonUsed[comparison])
+            continue;
+        
+        const string &routine = COMPARISON_ROUTINES[comparison];
+        
+        out << endl << "// shared " << routine.substr(1) << " routine: D = return-address" << endl;
+        out <<
+            "(" << routine << ")\n"
+            "\t@R15\n"
+            "\tM=D\n"
+            
+            // D = x-y, with y popped and x assumed true
+            "\t@SP\n"
+            "\tAM=M-1\n"
+            "\tD=M\n"
+            "\tA=A-1\n"
+            "\tD=M-D\n"
+            "\tM=-1\n"
+            "\t@" << routine << "$true\n"
+            "\tD;" << COMPARISON_JUMPS[comparison] << "\n"
+            "\t@SP\n"
+            "\tA=M-1\n"
+            "\tM=0\n"
+            "(" << routine << "$true)\n"
+            
+            // goto return-address
+            "\t@R15\n"
+            "\tA=M\n"
+            "\t0;JMP\n";
+        
+        comparisonUsed[comparison] = false;
+    }
+    
+    callUsed = returnUsed = false;
+}
+
+void CodeWriter::writeArithmetic(Opcode command)
+{
+	if(command == Opcode::Add)
 	{
 		out <<
 			"\t@SP\n"
@@ -293,7 +532,7 @@ void CodeWriter::writeArithmetic(string command)
 			"\t@SP\n"
 			"\tM=M-1\n";
 	}
-	else if(command == "sub")
+	else if(command == Opcode::Sub)
 	{
 		out <<
 			"\t@SP\n"
@@ -304,14 +543,29 @@ void CodeWriter::writeArithmetic(string command)
 			"\t@SP\n"
 			"\tM=M-1\n";
 	}
-	else if(command == "neg")
+	else if(command == Opcode::Neg)
 	{
 		out <<
 			"\t@SP\n"
 			"\tA=M-1\n"
 			"\tM=-M\n";
 	}
-	else if (command == "eq")
+	else if(sharedComparisons && (command == Opcode::Eq || command == Opcode::Gt || command == Opcode::Lt))
+	{
+		int comparison = command == Opcode::Eq ? 0 : command == Opcode::Gt ? 1 : 2;
+		string returnLabel = nextReturnLabel();
+		
+		// D = return-address, goto the comparison routine
+		out <<
+			"\t@" << returnLabel << "\n"
+			"\tD=A\n"
+			"\t@" << COMPARISON_ROUTINES[comparison] << "\n"
+			"\t0;JMP\n"
+			"(" << returnLabel << ")\n";
+		
+		comparisonUsed[comparison] = true;
+	}
+	else if(command == Opcode::Eq)
 	{
 		out <<
 			"\t@SP\n"
@@ -338,7 +592,7 @@ void CodeWriter::writeArithmetic(string command)
 
 		branchCount++;
 	}
-	else if (command == "gt")
+	else if(command == Opcode::Gt)
 	{
 		out <<
 			"\t@SP\n"
@@ -365,7 +619,7 @@ void CodeWriter::writeArithmetic(string command)
 
 		branchCount++;
 	}
-	else if (command == "lt")
+	else if(command == Opcode::Lt)
 	{
 		out <<
 			"\t@SP\n"
@@ -392,7 +646,7 @@ void CodeWriter::writeArithmetic(string command)
 
 		branchCount++;
 	}
-	else if (command == "and")
+	else if(command == Opcode::And)
 	{
 		out <<
 			"\t@SP\n"
@@ -403,7 +657,7 @@ void CodeWriter::writeArithmetic(string command)
 			"\t@SP\n"
 			"\tM=M-1\n";
 	}
-	else if (command == "or")
+	else if(command == Opcode::Or)
 	{
 	out <<
 		"\t@SP\n"
@@ -414,7 +668,7 @@ void CodeWriter::writeArithmetic(string command)
 		"\t@SP\n"
 		"\tM=M-1\n";
 	}
-	else if (command == "not")
+	else if(command == Opcode::Not)
 	{
 	out <<
 		"\t@SP\n"
@@ -422,28 +676,35 @@ void CodeWriter::writeArithmetic(string command)
 		"\tM=!M\n";
 	}
 	else
-		throw runtime_error("Arithmetic command '" + command + "' not valid command");
+		throw runtime_error("Arithmetic command '" + string(opcodeName(command)) + "' not valid command");
 }
 
-void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
+void CodeWriter::writePushPop(Opcode type, Segment segment, int index)
 {
-    if(index < 0 || index > 32767)
+    // folded constants can be negative
+    bool literal = type == Opcode::Push && segment == Segment::Constant;
+    
+    if(index < (literal ? -32768 : 0) || index > 32767)
         throw runtime_error("Push/pop command: " + to_string(index) + " not a valid index");
     
-    if(type == CommandType::Push)
+    if(type == Opcode::Push)
     {
-        if(segment == "constant")
+        if(segment == Segment::Constant)
         {
+            if(index < 0)
+                writeLoad(segment, index);
+            else
+                out <<
+                    "\t@" + to_string(index) + "\n"
+                    "\tD=A\n";
             out <<
-                "\t@" + to_string(index) + "\n"
-                "\tD=A\n"
                 "\t@SP\n"
                 "\tA=M\n"
                 "\tM=D\n"
                 "\t@SP\n"
                 "\tM=M+1\n";
         }
-        else if(segment == "local")
+        else if(segment == Segment::Local)
         {
             out <<
                 "\t@" + to_string(index) + "\n"
@@ -458,7 +719,7 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                 "\t@SP\n"
                 "\tM=M+1\n";
         }
-        else if(segment == "argument")
+        else if(segment == Segment::Argument)
         {
             out <<
                 "\t@" + to_string(index) + "\n"
@@ -473,7 +734,7 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                 "\t@SP\n"
                 "\tM=M+1\n";
         }
-        else if(segment == "this")
+        else if(segment == Segment::This)
         {
             out <<
                 "\t@" + to_string(index) + "\n"
@@ -488,7 +749,7 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                 "\t@SP\n"
                 "\tM=M+1\n";
         }
-        else if(segment == "that")
+        else if(segment == Segment::That)
         {
             out <<
                 "\t@" + to_string(index) + "\n"
@@ -503,7 +764,7 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                 "\t@SP\n"
                 "\tM=M+1\n";
         }
-        else if(segment == "pointer")
+        else if(segment == Segment::Pointer)
         {
             if(index > POINTER_SIZE - 1)
                 throw runtime_error("Push command: 'pointer' segment index must be betweeen 0-" + to_string(POINTER_SIZE - 1));
@@ -531,7 +792,7 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                     "\tM=M+1\n";
             }
         }
-        else if(segment == "temp")
+        else if(segment == Segment::Temp)
         {
             if(index > TEMP_SIZE - 1)
                 throw runtime_error("Push command: 'temp' segment index must be betweeen 0-" + to_string(TEMP_SIZE - 1));
@@ -548,7 +809,7 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                 "\t@SP\n"
                 "\tM=M+1\n";
         }
-        else if(segment == "static")
+        else if(segment == Segment::Static)
         {
             if(index > STATIC_SIZE - 1)
                 throw runtime_error("Push command: 'static' segment index must be betweeen 0-" + to_string(STATIC_SIZE - 1));
@@ -562,18 +823,31 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                 "\t@SP\n"
                 "\tM=M+1\n";
         }
+        else if(segment == Segment::Stack)
+        {
+            if(index < 1)
+                throw runtime_error("Push command: 'stack' segment index must be at least 1");
+            
+            writeLoad(segment, index);
+            out <<
+                "\t@SP\n"
+                "\tA=M\n"
+                "\tM=D\n"
+                "\t@SP\n"
+                "\tM=M+1\n";
+        }
         else
-            throw runtime_error("Push command: '" + segment + "' not a valid segment");
+            throw runtime_error("Push command: '" + string(segmentName(segment)) + "' not a valid segment");
     }
-    else if(type == CommandType::Pop)
+    else if(type == Opcode::Pop)
     {
-        if(segment == "constant")
+        if(segment == Segment::Constant)
         {
             out <<
                 "\t@SP\n"
                 "\tM=M-1\n";
         }
-        else if(segment == "local")
+        else if(segment == Segment::Local)
         {
             out <<
                 "\t@SP\n"
@@ -596,7 +870,7 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                 "\tA=M\n"
                 "\tM=D\n";
         }
-        else if(segment == "argument")
+        else if(segment == Segment::Argument)
         {
             out <<
                 "\t@SP\n"
@@ -619,7 +893,7 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                 "\tA=M\n"
                 "\tM=D\n";
         }
-        else if(segment == "this")
+        else if(segment == Segment::This)
         {
             out <<
                 "\t@SP\n"
@@ -642,7 +916,7 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                 "\tA=M\n"
                 "\tM=D\n";
         }
-        else if(segment == "that")
+        else if(segment == Segment::That)
         {
             out <<
                 "\t@SP\n"
@@ -665,7 +939,7 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                 "\tA=M\n"
                 "\tM=D\n";
         }
-        else if(segment == "pointer")
+        else if(segment == Segment::Pointer)
         {
             if(index > POINTER_SIZE - 1)
                 throw runtime_error("Pop command: 'pointer' segment index must be betweeen 0-" + to_string(POINTER_SIZE - 1));
@@ -693,7 +967,7 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                     "\tM=M-1\n";
             }
         }
-        else if(segment == "temp")
+        else if(segment == Segment::Temp)
         {
             if(index > TEMP_SIZE - 1)
                 throw runtime_error("Pop command: 'temp' segment index must be betweeen 0-" + to_string(TEMP_SIZE - 1));
@@ -718,7 +992,7 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                 "\tA=M\n"
                 "\tM=D\n";
         }
-        else if(segment == "static")
+        else if(segment == Segment::Static)
         {
             if(index > STATIC_SIZE - 1)
                 throw runtime_error("Pop command: 'static' segment index must be betweeen 0-" + to_string(STATIC_SIZE - 1));
@@ -732,8 +1006,37 @@ void CodeWriter::writePushPop(CommandType type, std::string segment, int index)
                 "\t@SP\n"
                 "\tM=M-1\n";
         }
+        else if(segment == Segment::Stack)
+        {
+            if(index < 1)
+                throw runtime_error("Pop command: 'stack' segment index must be at least 1");
+            
+            // the slot is counted from the top left by the pop
+            if(storesDirectly(segment, index))
+            {
+                out <<
+                    "\t@SP\n"
+                    "\tAM=M-1\n"
+                    "\tD=M\n";
+                writeStore(segment, index);
+            }
+            else
+            {
+                out <<
+                    "\t@SP\n"
+                    "\tM=M-1\n";
+                writeAddress(segment, index);
+                out <<
+                    "\t@SP\n"
+                    "\tA=M\n"
+                    "\tD=M\n"
+                    "\t@R13\n"
+                    "\tA=M\n"
+                    "\tM=D\n";
+            }
+        }
         else
-            throw runtime_error("Pop command: '" + segment + "' not a valid segment");
+            throw runtime_error("Pop command: '" + string(segmentName(segment)) + "' not a valid segment");
     }
     else
         throw runtime_error("Push/pop command: invalid command type");
@@ -784,6 +1087,687 @@ void CodeWriter::writeAnnotation(CommandType type, std::string argument1, std::s
 
 
 
+void CodeWriter::writeAnnotation(const Command &command, const NameTable &names)
+{
+    out << "\t// " << opcodeName(command.opcode);
+    
+    switch(command.opcode)
+    {
+        case Opcode::Push:
+        case Opcode::Pop:
+            out << " " << segmentName(command.segment) << " " << command.index;
+            break;
+        case Opcode::Label:
+        case Opcode::Goto:
+        case Opcode::If:
+            out << " " << names.get(command.name);
+            break;
+        case Opcode::Function:
+        case Opcode::Call:
+            out << " " << names.get(command.name) << " " << command.index;
+            break;
+        default:
+            break;
+    }
+    
+    out << endl;
+}
+
+void CodeWriter::write(const Command &command, const NameTable &names)
+{
+    writeAnnotation(command, names);
+    
+    switch(command.opcode)
+    {
+        case Opcode::Push:
+        case Opcode::Pop:
+            writePushPop(command.opcode, command.segment, command.index);
+            break;
+        case Opcode::Label:
+            writeLabel(names.get(command.name));
+            break;
+        case Opcode::Goto:
+            writeGoto(names.get(command.name));
+            break;
+        case Opcode::If:
+            writeIf(names.get(command.name));
+            break;
+        case Opcode::Function:
+            writeFunction(names.get(command.name), command.index);
+            break;
+        case Opcode::Call:
+            writeCall(names.get(command.name), command.index);
+            break;
+        case Opcode::Return:
+            writeReturn();
+            break;
+        default:
+            writeArithmetic(command.opcode);
+            break;
+    }
+}
+
+static bool isMoved(const Command &command)
+{
+    return (command.opcode == Opcode::Push || command.opcode == Opcode::Pop) && command.segment == Segment::Static && command.name >= 0;
+}
+
+size_t CodeWriter::write(const Command *commands, size_t count, const NameTable &names)
+{
+    // a static moved out of its file is written alone, under the name of that file
+    if(isMoved(commands[0]))
+    {
+        string own = prefix;
+        prefix = names.get(commands[0].name);
+        
+        if(stackCaching)
+            writeCached(commands[0], names);
+        else
+            write(commands[0], names);
+        
+        prefix = own;
+        return 1;
+    }
+    
+    for(size_t i = 1; i < count; i++)
+        if(isMoved(commands[i]))
+            count = i;
+    
+    if(peephole || stackCaching)
+    {
+        size_t covered = writeBranch(commands, count, names);
+        
+        if(covered > 0)
+        {
+            rewrites++;
+            return covered;
+        }
+    }
+    
+    // the cache already keeps what the peephole patterns would out of memory
+    if(stackCaching)
+    {
+        writeCached(commands[0], names);
+        return 1;
+    }
+    
+    if(peephole)
+    {
+        size_t covered = writePeephole(commands, count, names);
+        
+        if(covered > 0)
+        {
+            rewrites++;
+            return covered;
+        }
+    }
+    
+    write(commands[0], names);
+    return 1;
+}
+
+void CodeWriter::setPeephole(bool enabled)
+{
+    peephole = enabled;
+}
+
+int CodeWriter::getRewrites()
+{
+    return rewrites;
+}
+
+// Whether a push or pop is in range for its segment; those that are not are
+// left to writePushPop to report
+static bool inRange(const Command &command)
+{
+    switch(command.segment)
+    {
+        case Segment::Constant:
+            return command.index >= (command.opcode == Opcode::Push ? -32768 : 0) && command.index <= 32767;
+        case Segment::Stack:
+            return command.index >= 1 && command.index <= 32767;
+        case Segment::Pointer:
+            return command.index >= 0 && command.index < POINTER_SIZE;
+        case Segment::Temp:
+            return command.index >= 0 && command.index < TEMP_SIZE;
+        case Segment::Static:
+            return command.index >= 0 && command.index < STATIC_SIZE;
+        default:
+            return command.index >= 0 && command.index <= 32767;
+    }
+}
+
+static const char *baseName(Segment segment)
+{
+    switch(segment)
+    {
+        case Segment::Local:
+            return "LCL";
+        case Segment::Argument:
+            return "ARG";
+        case Segment::This:
+            return "THIS";
+        default:
+            return "THAT";
+    }
+}
+
+static bool isIndirect(Segment segment)
+{
+    return segment == Segment::Local || segment == Segment::Argument || segment == Segment::This || segment == Segment::That;
+}
+
+static bool isComparison(Opcode opcode)
+{
+    return opcode == Opcode::Eq || opcode == Opcode::Gt || opcode == Opcode::Lt;
+}
+
+// The length of a run writeBranch fuses: a comparison, not or both, then
+// if-goto; 0 when the window does not start with one
+static size_t branchLength(const Command *commands, size_t count)
+{
+    size_t length = 0;
+    
+    if(length < count && isComparison(commands[length].opcode))
+        length++;
+    if(length < count && commands[length].opcode == Opcode::Not)
+        length++;
+    
+    if(length == 0 || length >= count || commands[length].opcode != Opcode::If)
+        return 0;
+    
+    return length + 1;
+}
+
+// A comparison or not followed by if-goto: jump on the operands themselves
+// rather than on a boolean made of them and pushed in between
+size_t CodeWriter::writeBranch(const Command *commands, size_t count, const NameTable &names)
+{
+    size_t length = branchLength(commands, count);
+    
+    if(length == 0)
+        return 0;
+    
+    for(size_t i = 0; i < length; i++)
+        writeAnnotation(commands[i], names);
+    
+    const Command &first = commands[0];
+    bool negated = commands[length - 2].opcode == Opcode::Not;
+    string jump;
+    
+    writeTop();
+    
+    if(isComparison(first.opcode))
+    {
+        int comparison = first.opcode == Opcode::Eq ? 0 : first.opcode == Opcode::Gt ? 1 : 2;
+        jump = negated ? NEGATED_JUMPS[comparison] : COMPARISON_JUMPS[comparison];
+        
+        out <<
+            "\t@SP\n"
+            "\tAM=M-1\n"
+            "\tD=M-D\n";
+    }
+    else
+    {
+        // not is bitwise: !x is true for any x but -1, so test x+1
+        jump = "JNE";
+        out << "\tD=D+1\n";
+    }
+    
+    out
+        << "\t@" << function_name << "$" << names.get(commands[length - 1].name) << endl
+        << "\tD;" << jump << "\n";
+    
+    // if-goto consumed the condition
+    cached = false;
+    return length;
+}
+
+size_t CodeWriter::writePeephole(const Command *commands, size_t count, const NameTable &names)
+{
+    if(count < 2 || commands[0].opcode != Opcode::Push || !inRange(commands[0]))
+        return 0;
+    
+    const Command &push = commands[0];
+    const Command &next = commands[1];
+    
+    // push x, then a run writeBranch fuses: its operand is already in D
+    if(branchLength(commands + 1, count - 1) > 0)
+    {
+        writeAnnotation(push, names);
+        writeLoad(push.segment, push.index);
+        cached = true;
+        return 1 + writeBranch(commands + 1, count - 1, names);
+    }
+    
+    switch(next.opcode)
+    {
+        // push x, pop y: y = x, without going through the stack
+        case Opcode::Pop:
+        {
+            if(next.segment == Segment::Constant || !inRange(next))
+                return 0;
+            
+            writeAnnotation(push, names);
+            writeAnnotation(next, names);
+            
+            if(storesDirectly(next.segment, next.index))
+            {
+                writeLoad(push.segment, push.index);
+                writeStore(next.segment, next.index);
+            }
+            else
+            {
+                writeAddress(next.segment, next.index);
+                writeLoad(push.segment, push.index);
+                out <<
+                    "\t@R13\n"
+                    "\tA=M\n"
+                    "\tM=D\n";
+            }
+            return 2;
+        }
+        
+        // push x, binary operation: apply x to the top of the stack in place
+        case Opcode::Add:
+        case Opcode::Sub:
+        case Opcode::And:
+        case Opcode::Or:
+        {
+            writeAnnotation(push, names);
+            writeAnnotation(next, names);
+            
+            bool one = push.segment == Segment::Constant && push.index == 1;
+            
+            if(one && (next.opcode == Opcode::Add || next.opcode == Opcode::Sub))
+            {
+                out <<
+                    "\t@SP\n"
+                    "\tA=M-1\n"
+                    << (next.opcode == Opcode::Add ? "\tM=M+1\n" : "\tM=M-1\n");
+                return 2;
+            }
+            
+            static const char *operations[]{"\tM=M+D\n", "\tM=M-D\n", "\tM=D&M\n", "\tM=D|M\n"};
+            int operation = next.opcode == Opcode::Add ? 0 : next.opcode == Opcode::Sub ? 1 : next.opcode == Opcode::And ? 2 : 3;
+            
+            writeLoad(push.segment, push.index);
+            out <<
+                "\t@SP\n"
+                "\tA=M-1\n"
+                << operations[operation];
+            return 2;
+        }
+        
+        // push x, comparison: assume true, and clear it when it is not
+        case Opcode::Eq:
+        case Opcode::Gt:
+        case Opcode::Lt:
+        {
+            // shared comparisons are there to save space, which this would not
+            if(sharedComparisons)
+                return 0;
+            
+            writeAnnotation(push, names);
+            writeAnnotation(next, names);
+            
+            string label = branchLabel() + "T";
+            branchCount++;
+            
+            writeLoad(push.segment, push.index);
+            out <<
+                "\t@SP\n"
+                "\tA=M-1\n"
+                "\tD=M-D\n"
+                "\tM=-1\n"
+                "\t@" << label << "\n"
+                << (next.opcode == Opcode::Eq ? "\tD;JEQ\n" : next.opcode == Opcode::Gt ? "\tD;JGT\n" : "\tD;JLT\n") <<
+                "\t@SP\n"
+                "\tA=M-1\n"
+                "\tM=0\n"
+                "(" << label << ")\n";
+            return 2;
+        }
+        
+        // push x, if-goto: test x where it is
+        case Opcode::If:
+        {
+            writeAnnotation(push, names);
+            writeAnnotation(next, names);
+            
+            writeLoad(push.segment, push.index);
+            out
+                << "\t@" << function_name << "$" << names.get(next.name) << endl
+                << "\tD;JNE\n";
+            return 2;
+        }
+        
+        default:
+            return 0;
+    }
+}
+
+// With the stack cached, its top lives in D rather than at SP-1 whenever
+// cached is set, and SP points to where it would be stored. Every label is
+// reached with the whole stack in memory, so the cache is stored before each
+// label and before each jump, call and return.
+void CodeWriter::writeCached(const Command &command, const NameTable &names)
+{
+    // writePushPop reports the ones out of range
+    if((command.opcode == Opcode::Push || command.opcode == Opcode::Pop) && !inRange(command))
+    {
+        writePushPop(command.opcode, command.segment, command.index);
+        return;
+    }
+    
+    writeAnnotation(command, names);
+    
+    switch(command.opcode)
+    {
+        case Opcode::Push:
+            writeSpill();
+            writeLoad(command.segment, command.index);
+            cached = true;
+            break;
+        
+        case Opcode::Pop:
+            if(command.segment == Segment::Constant)
+            {
+                if(!cached)
+                    out <<
+                        "\t@SP\n"
+                        "\tM=M-1\n";
+            }
+            else if(storesDirectly(command.segment, command.index))
+            {
+                writeTop();
+                writeStore(command.segment, command.index);
+            }
+            else
+            {
+                // the address of a stack slot moves with SP, so pop the value first
+                if(command.segment == Segment::Stack)
+                    writeTop();
+                
+                if(cached)
+                    out <<
+                        "\t@R14\n"
+                        "\tM=D\n";
+                writeAddress(command.segment, command.index);
+                if(cached)
+                    out <<
+                        "\t@R14\n"
+                        "\tD=M\n";
+                else
+                    writeTop();
+                out <<
+                    "\t@R13\n"
+                    "\tA=M\n"
+                    "\tM=D\n";
+            }
+            cached = false;
+            break;
+        
+        case Opcode::Neg:
+        case Opcode::Not:
+            writeTop();
+            out << (command.opcode == Opcode::Neg ? "\tD=-D\n" : "\tD=!D\n");
+            cached = true;
+            break;
+        
+        case Opcode::Add:
+        case Opcode::Sub:
+        case Opcode::And:
+        case Opcode::Or:
+        {
+            static const char *operations[]{"\tD=D+M\n", "\tD=M-D\n", "\tD=D&M\n", "\tD=D|M\n"};
+            int operation = command.opcode == Opcode::Add ? 0 : command.opcode == Opcode::Sub ? 1 : command.opcode == Opcode::And ? 2 : 3;
+            
+            writeTop();
+            out <<
+                "\t@SP\n"
+                "\tAM=M-1\n"
+                << operations[operation];
+            cached = true;
+            break;
+        }
+        
+        case Opcode::Eq:
+        case Opcode::Gt:
+        case Opcode::Lt:
+        {
+            // the shared routines take both operands from memory
+            if(sharedComparisons)
+            {
+                writeSpill();
+                writeArithmetic(command.opcode);
+                break;
+            }
+            
+            string label = branchLabel();
+            branchCount++;
+            
+            writeTop();
+            out <<
+                "\t@SP\n"
+                "\tAM=M-1\n"
+                "\tD=M-D\n"
+                "\t@" << label << "T\n"
+                << (command.opcode == Opcode::Eq ? "\tD;JEQ\n" : command.opcode == Opcode::Gt ? "\tD;JGT\n" : "\tD;JLT\n") <<
+                "\tD=0\n"
+                "\t@" << label << "E\n"
+                "\t0;JMP\n"
+                "(" << label << "T)\n"
+                "\tD=-1\n"
+                "(" << label << "E)\n";
+            cached = true;
+            break;
+        }
+        
+        case Opcode::If:
+            writeTop();
+            out
+                << "\t@" << function_name << "$" << names.get(command.name) << endl
+                << "\tD;JNE\n";
+            cached = false;
+            break;
+        
+        case Opcode::Label:
+            writeSpill();
+            writeLabel(names.get(command.name));
+            break;
+        
+        case Opcode::Goto:
+            writeSpill();
+            writeGoto(names.get(command.name));
+            break;
+        
+        case Opcode::Function:
+            writeSpill();
+            writeFunction(names.get(command.name), command.index);
+            break;
+        
+        case Opcode::Call:
+            writeSpill();
+            writeCall(names.get(command.name), command.index);
+            break;
+        
+        default:
+            writeSpill();
+            writeReturn();
+            break;
+    }
+}
+
+// Stores a cached top of the stack, leaving the whole stack in memory
+void CodeWriter::writeSpill()
+{
+    if(!cached)
+        return;
+    
+    out <<
+        "\t@SP\n"
+        "\tAM=M+1\n"
+        "\tA=A-1\n"
+        "\tM=D\n";
+    cached = false;
+}
+
+// Makes sure the top of the stack is in D, popping it when it is not cached
+void CodeWriter::writeTop()
+{
+    if(cached)
+        return;
+    
+    out <<
+        "\t@SP\n"
+        "\tAM=M-1\n"
+        "\tD=M\n";
+    cached = true;
+}
+
+// D = segment[index]
+void CodeWriter::writeLoad(Segment segment, int index)
+{
+    switch(segment)
+    {
+        case Segment::Constant:
+            if(index >= -1 && index <= 1)
+                out << "\tD=" << index << "\n";
+            else if(index < 0)
+            {
+                // -32768 is one below the lowest negation of an A-instruction
+                out <<
+                    "\t@" << min(-index, 32767) << "\n"
+                    "\tD=-A\n";
+                if(index < -32767)
+                    out << "\tD=D-1\n";
+            }
+            else
+                out <<
+                    "\t@" << index << "\n"
+                    "\tD=A\n";
+            break;
+        
+        case Segment::Pointer:
+            out <<
+                "\t@" << (index == 0 ? "THIS" : "THAT") << "\n"
+                "\tD=M\n";
+            break;
+        
+        case Segment::Temp:
+            out <<
+                "\t@R" << 5 + index << "\n"
+                "\tD=M\n";
+            break;
+        
+        case Segment::Static:
+            out <<
+                "\t@" << file_prefix() << "." << index << "\n"
+                "\tD=M\n";
+            break;
+        
+        case Segment::Stack:
+            out << "\t@SP\n";
+            if(index <= STORE_STEPS)
+            {
+                out << "\tA=M-1\n";
+                for(int i = 1; i < index; i++)
+                    out << "\tA=A-1\n";
+            }
+            else
+                out <<
+                    "\tD=M\n"
+                    "\t@" << index << "\n"
+                    "\tA=D-A\n";
+            out << "\tD=M\n";
+            break;
+        
+        default:
+            out << "\t@" << baseName(segment) << "\n";
+            if(index <= 1)
+                out << (index == 0 ? "\tA=M\n" : "\tA=M+1\n");
+            else
+                out <<
+                    "\tD=M\n"
+                    "\t@" << index << "\n"
+                    "\tA=D+A\n";
+            out << "\tD=M\n";
+            break;
+    }
+}
+
+// R13 = the address of segment[index], for a pointer segment or the stack
+void CodeWriter::writeAddress(Segment segment, int index)
+{
+    if(segment == Segment::Stack)
+    {
+        out <<
+            "\t@SP\n"
+            "\tD=M\n"
+            "\t@" << index << "\n"
+            "\tD=D-A\n"
+            "\t@R13\n"
+            "\tM=D\n";
+        return;
+    }
+    
+    out <<
+        "\t@" << baseName(segment) << "\n"
+        "\tD=M\n"
+        "\t@" << index << "\n"
+        "\tD=D+A\n"
+        "\t@R13\n"
+        "\tM=D\n";
+}
+
+// Whether writeStore can store D without an address in R13
+bool CodeWriter::storesDirectly(Segment segment, int index)
+{
+    return !(isIndirect(segment) || segment == Segment::Stack) || index <= STORE_STEPS;
+}
+
+// segment[index] = D
+void CodeWriter::writeStore(Segment segment, int index)
+{
+    switch(segment)
+    {
+        case Segment::Pointer:
+            out << "\t@" << (index == 0 ? "THIS" : "THAT") << "\n";
+            break;
+        
+        case Segment::Temp:
+            out << "\t@R" << 5 + index << "\n";
+            break;
+        
+        case Segment::Static:
+            out << "\t@" << file_prefix() << "." << index << "\n";
+            break;
+        
+        case Segment::Stack:
+            assert(index <= STORE_STEPS);
+            
+            out <<
+                "\t@SP\n"
+                "\tA=M-1\n";
+            for(int i = 1; i < index; i++)
+                out << "\tA=A-1\n";
+            break;
+        
+        default:
+            assert(index <= STORE_STEPS);
+            
+            out <<
+                "\t@" << baseName(segment) << "\n"
+                << (index == 0 ? "\tA=M\n" : "\tA=M+1\n");
+            for(int i = 1; i < index; i++)
+                out << "\tA=A+1\n";
+            break;
+    }
+    
+    out << "\tM=D\n";
+}
+
 void CodeWriter::setFunctionName(std::string name)
 {
     function_name = name;
@@ -794,3 +1778,23 @@ std::string CodeWriter::getFunctionName()
 {
     return function_name;
 }
+
+int CodeWriter::countInstructions(const string &code)
+{
+    int count = 0;
+    
+    for(size_t begin = 0; begin < code.size(); )
+    {
+        size_t end = code.find('\n', begin);
+        if(end == string::npos)
+            end = code.size();
+        
+        size_t first = code.find_first_not_of(" \t\r", begin);
+        if(first < end && code[first] != '(' && code.compare(first, 2, "//") != 0)
+            count++;
+        
+        begin = end + 1;
+    }
+    
+    return count;
+}
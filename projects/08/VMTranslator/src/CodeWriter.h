@@ -29,6 +29,7 @@
 #ifndef CODE_WRITER_H
 #define CODE_WRITER_H
 
+#include "Command.h"
 #include "Common.h"
 
 #include <string>
@@ -41,15 +42,49 @@ public:
 	CodeWriter(std::ostream &outputStream);
 	void setFilename(std::string filename);
     void writeInit();
-    void writeLabel(std::string label);
-    void writeGoto(std::string label);
-    void writeIf(std::string label);
-    void writeCall(std::string functionName, int numArgs);
-    void writeFunction(std::string functionName, int numArgs);
+    void writeLabel(const std::string &label);
+    void writeGoto(const std::string &label);
+    void writeIf(const std::string &label);
+    void writeCall(const std::string &functionName, int numArgs);
+    void writeFunction(const std::string &functionName, int numArgs);
     void writeReturn();
-	void writeArithmetic(std::string command);
-	void writePushPop(CommandType type, std::string segment, int index);
+	void writeArithmetic(Opcode command);
+	void writePushPop(Opcode type, Segment segment, int index);
     void writeAnnotation(CommandType type, std::string argument1, std::string argument2);
+    void writeAnnotation(const Command &command, const NameTable &names);
+    
+    // writes the annotation and the code of a command, dispatching on its opcode
+    void write(const Command &command, const NameTable &names);
+    
+    // writes the code of the commands at the start of a window and returns how
+    // many it covered: a run the peephole optimizer has a pattern for when it
+    // is enabled, otherwise the first command alone. With the top of the
+    // stack cached, only comparisons and not followed by if-goto are fused.
+    size_t write(const Command *commands, size_t count, const NameTable &names);
+    
+    // peephole optimization of push/pop sequences; off by default
+    void setPeephole(bool enabled);
+    
+    // the windows of commands rewritten by the peephole optimizer so far
+    int getRewrites();
+    
+    // calls and returns through one shared routine each rather than inline;
+    // off by default
+    void setTrampolines(bool enabled);
+    
+    // eq, gt and lt through one shared routine each rather than inline; off by default
+    void setSharedComparisons(bool enabled);
+    
+    // keeps the top of the stack in D between straight-line commands, storing
+    // it at labels, branches, calls and returns; off by default
+    void setStackCaching(bool enabled);
+    
+    // writes what the code so far still needs, once, after the last command:
+    // the top of the stack when it is cached, and the shared routines it jumps to
+    void writeSubroutines();
+    
+    // the instructions of generated code: its lines that are neither comments nor labels
+    static int countInstructions(const std::string &code);
     
 protected:
     void setFunctionName(std::string name);
@@ -61,6 +96,25 @@ private:
     std::string function_name;
 	unsigned int branchCount;
     unsigned int returnCount;
+    bool peephole;
+    int rewrites;
+    bool trampolines;
+    bool callUsed;
+    bool returnUsed;
+    bool sharedComparisons;
+    bool comparisonUsed[3];
+    bool stackCaching;
+    bool cached;
+    
+    size_t writePeephole(const Command *commands, size_t count, const NameTable &names);
+    size_t writeBranch(const Command *commands, size_t count, const NameTable &names);
+    void writeCached(const Command &command, const NameTable &names);
+    void writeSpill();
+    void writeTop();
+    void writeLoad(Segment segment, int index);
+    void writeAddress(Segment segment, int index);
+    void writeStore(Segment segment, int index);
+    bool storesDirectly(Segment segment, int index);
     
     inline std::string nextReturnLabel()
     {
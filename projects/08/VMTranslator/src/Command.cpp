@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Command module.
+ */
+
+#include "Command.h"
+
+using namespace std;
+
+int NameTable::intern(const string &name)
+{
+    auto found = ids.find(name);
+    if(found != ids.end())
+        return found->second;
+
+    int id = static_cast<int>(names.size());
+    ids.emplace(name, id);
+    names.push_back(name);
+
+    return id;
+}
+
+int NameTable::find(const string &name) const
+{
+    auto found = ids.find(name);
+    return found == ids.end() ? -1 : found->second;
+}
+
+const string &NameTable::get(int id) const
+{
+    return names.at(id);
+}
+
+const char *opcodeName(Opcode opcode)
+{
+    static const char *names[]{"add", "sub", "neg", "eq", "gt", "lt", "and", "or", "not",
+                               "push", "pop", "label", "goto", "if-goto", "function", "call", "return"};
+
+    return names[static_cast<int>(opcode)];
+}
+
+const char *segmentName(Segment segment)
+{
+    static const char *names[]{"", "constant", "local", "argument", "this", "that", "pointer", "temp", "static", "stack"};
+
+    return names[static_cast<int>(segment)];
+}
+
+CommandType commandType(Opcode opcode)
+{
+    switch(opcode)
+    {
+        case Opcode::Push:
+            return CommandType::Push;
+        case Opcode::Pop:
+            return CommandType::Pop;
+        case Opcode::Label:
+            return CommandType::Label;
+        case Opcode::Goto:
+            return CommandType::Goto;
+        case Opcode::If:
+            return CommandType::If;
+        case Opcode::Function:
+            return CommandType::Function;
+        case Opcode::Call:
+            return CommandType::Call;
+        case Opcode::Return:
+            return CommandType::Return;
+        default:
+            return CommandType::Arithmetic;
+    }
+}
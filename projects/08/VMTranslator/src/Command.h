@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Command module: the typed form of VM commands.
+ */
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include "Common.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Every VM command, arithmetic ones included
+enum class Opcode : uint8_t
+{
+    Add,
+    Sub,
+    Neg,
+    Eq,
+    Gt,
+    Lt,
+    And,
+    Or,
+    Not,
+    Push,
+    Pop,
+    Label,
+    Goto,
+    If,
+    Function,
+    Call,
+    Return
+};
+
+enum class Segment : uint8_t
+{
+    None,
+    Constant,
+    Local,
+    Argument,
+    This,
+    That,
+    Pointer,
+    Temp,
+    Static,
+    
+    // not in .vm files: the slot index below the top of the stack, counted
+    // without the value a push or pop moves; for inlined functions
+    Stack
+};
+
+// One parsed VM command. Labels and function names are kept as ids of a
+// NameTable, so commands can be copied and compared without touching strings.
+struct Command
+{
+    Opcode opcode;
+    Segment segment;
+
+    // the index of a push or pop, the local count of a function or the
+    // argument count of a call
+    int index;
+
+    // the label or function name; for a push or pop of static the inliner
+    // moved out of its file, the name of that file without .vm; or -1
+    int name;
+
+    // where the command came from, for errors
+    int line;
+};
+
+// Interns label and function names, handing out dense ids from 0
+class NameTable
+{
+public:
+    int intern(const std::string &name);
+
+    // the id of a name, or -1 when it was never interned
+    int find(const std::string &name) const;
+
+    const std::string &get(int id) const;
+
+private:
+    std::unordered_map<std::string, int> ids;
+    std::vector<std::string> names;
+};
+
+// The commands of one .vm file
+struct Module
+{
+    std::string filename;
+    std::vector<Command> commands;
+};
+
+// Text forms as they appear in .vm files
+const char *opcodeName(Opcode opcode);
+const char *segmentName(Segment segment);
+
+// The CommandType of the parser API an opcode belongs to
+CommandType commandType(Opcode opcode);
+
+#endif // COMMAND_H
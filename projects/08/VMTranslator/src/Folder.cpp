@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Folder module.
+ */
+
+#include "Folder.h"
+
+using namespace std;
+
+// A value as a 16-bit register holds it
+static int wrap(int value)
+{
+    value &= 0xFFFF;
+    return value > 32767 ? value - 65536 : value;
+}
+
+static bool isConstant(const Command &command)
+{
+    return command.opcode == Opcode::Push && command.segment == Segment::Constant;
+}
+
+static bool isConstant(const Command &command, int value)
+{
+    return isConstant(command) && command.index == value;
+}
+
+// x op y of a binary command; comparisons test x - y as the generated code does
+static bool evaluate(Opcode opcode, int x, int y, int &result)
+{
+    switch(opcode)
+    {
+        case Opcode::Add:
+            result = wrap(x + y);
+            return true;
+        case Opcode::Sub:
+            result = wrap(x - y);
+            return true;
+        case Opcode::And:
+            result = x & y;
+            return true;
+        case Opcode::Or:
+            result = x | y;
+            return true;
+        case Opcode::Eq:
+            result = wrap(x - y) == 0 ? -1 : 0;
+            return true;
+        case Opcode::Gt:
+            result = wrap(x - y) > 0 ? -1 : 0;
+            return true;
+        case Opcode::Lt:
+            result = wrap(x - y) < 0 ? -1 : 0;
+            return true;
+        default:
+            return false;
+    }
+}
+
+Folder::Folder() : folds{0}
+{
+}
+
+void Folder::fold(vector<Command> &commands)
+{
+    vector<Command> folded;
+    folded.reserve(commands.size());
+    
+    // the commands already folded end where the next one could fold into them
+    for(const Command &command : commands)
+    {
+        folded.push_back(command);
+        
+        while(reduce(folded))
+            folds++;
+    }
+    
+    commands.swap(folded);
+}
+
+int Folder::getFolds()
+{
+    return folds;
+}
+
+// Folds the commands at the end, if they can be
+bool Folder::reduce(vector<Command> &commands)
+{
+    size_t n = commands.size();
+    
+    if(n < 2)
+        return false;
+    
+    Command &last = commands[n - 1];
+    Command &previous = commands[n - 2];
+    
+    // neg or not of a constant
+    if((last.opcode == Opcode::Neg || last.opcode == Opcode::Not) && isConstant(previous))
+    {
+        previous.index = last.opcode == Opcode::Neg ? wrap(-previous.index) : ~previous.index;
+        commands.pop_back();
+        return true;
+    }
+    
+    // not not x, neg neg x
+    if((last.opcode == Opcode::Neg || last.opcode == Opcode::Not) && previous.opcode == last.opcode)
+    {
+        commands.resize(n - 2);
+        return true;
+    }
+    
+    // a binary operation of two constants
+    int result;
+    if(n >= 3 && isConstant(commands[n - 3]) && isConstant(previous) && evaluate(last.opcode, commands[n - 3].index, previous.index, result))
+    {
+        commands[n - 3].index = result;
+        commands.resize(n - 2);
+        return true;
+    }
+    
+    // x+0, x-0, x|0, x&-1
+    bool identity =
+        ((last.opcode == Opcode::Add || last.opcode == Opcode::Sub || last.opcode == Opcode::Or) && isConstant(previous, 0)) ||
+        (last.opcode == Opcode::And && isConstant(previous, -1));
+    
+    if(identity)
+    {
+        commands.resize(n - 2);
+        return true;
+    }
+    
+    return false;
+}
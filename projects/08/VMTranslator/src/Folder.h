@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Folder module: constant folding of VM commands.
+ */
+
+#ifndef FOLDER_H
+#define FOLDER_H
+
+#include "Command.h"
+
+#include <vector>
+
+// Evaluates constant arithmetic and drops identities of a module's commands
+// before they are written, with the 16-bit wrap of the Hack ALU. Pushes of
+// folded constants may have negative indices, which the CodeWriter accepts
+// for the constant segment only.
+class Folder
+{
+public:
+    Folder();
+    
+    // folds the commands in place
+    void fold(std::vector<Command> &commands);
+    
+    // the folds made so far
+    int getFolds();
+    
+private:
+    int folds;
+    
+    bool reduce(std::vector<Command> &commands);
+};
+
+#endif // FOLDER_H
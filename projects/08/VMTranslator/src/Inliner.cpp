@@ -0,0 +1,435 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Inliner module.
+ */
+
+#include "Inliner.h"
+
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+// The most commands a function body can have to be inlined
+const size_t INLINE_SIZE{12};
+
+// A function that can be inlined
+struct Callee
+{
+    size_t module;
+    
+    // its commands, without the function command
+    vector<Command> body;
+    
+    int locals;
+    
+    // 1 + the highest argument index its body uses
+    int arguments;
+    
+    // the stack depth before each command of the body, counted from the top
+    // of its frame; -1 for commands that never run
+    vector<int> depths;
+    
+    // whether the body sets THIS or THAT
+    bool saves[2];
+};
+
+// Finds the stack depth before each command of a body. False when a label is
+// reached with two depths, the stack would go into the frame, or the body
+// runs off its end, none of which compiled code does.
+static bool measureDepths(const vector<Command> &body, vector<int> &depths)
+{
+    unordered_map<int, int> labels;
+    unordered_set<int> dead;
+    unordered_set<int> jumps;
+    
+    auto jump = [&](int label, int depth)
+    {
+        jumps.insert(label);
+        auto found = labels.find(label);
+        if(dead.count(label) > 0 || (found != labels.end() && found->second != depth))
+            return false;
+        labels[label] = depth;
+        return true;
+    };
+    
+    depths.assign(body.size(), -1);
+    int depth = 0;
+    bool reachable = true;
+    
+    for(size_t i = 0; i < body.size(); i++)
+    {
+        const Command &command = body[i];
+        
+        if(command.opcode == Opcode::Label)
+        {
+            auto found = labels.find(command.name);
+            
+            if(reachable && found != labels.end() && found->second != depth)
+                return false;
+            
+            if(reachable)
+                labels[command.name] = depth;
+            else if(found != labels.end())
+            {
+                depth = found->second;
+                reachable = true;
+            }
+            else
+                dead.insert(command.name);
+        }
+        
+        if(!reachable)
+            continue;
+        
+        depths[i] = depth;
+        
+        int needed = 0;
+        switch(command.opcode)
+        {
+            case Opcode::Push:
+                depth++;
+                break;
+            case Opcode::Pop:
+                needed = 1;
+                depth--;
+                break;
+            case Opcode::Neg:
+            case Opcode::Not:
+                needed = 1;
+                break;
+            case Opcode::If:
+                needed = 1;
+                depth--;
+                if(!jump(command.name, depth))
+                    return false;
+                break;
+            case Opcode::Goto:
+                if(!jump(command.name, depth))
+                    return false;
+                reachable = false;
+                break;
+            case Opcode::Call:
+                needed = command.index;
+                depth += 1 - command.index;
+                break;
+            case Opcode::Return:
+                needed = 1;
+                reachable = false;
+                break;
+            case Opcode::Label:
+                break;
+            case Opcode::Function:
+                return false;
+            default:
+                needed = 2;
+                depth--;
+                break;
+        }
+        
+        if(depths[i] < needed)
+            return false;
+    }
+    
+    for(int label : jumps)
+        if(labels.count(label) == 0)
+            return false;
+    
+    return !reachable;
+}
+
+// The callee form of a function, when its body can be inlined
+static bool analyze(const vector<Command> &body, Callee &callee)
+{
+    if(body.size() > INLINE_SIZE || !measureDepths(body, callee.depths))
+        return false;
+    
+    callee.arguments = 0;
+    callee.saves[0] = callee.saves[1] = false;
+    
+    for(const Command &command : body)
+    {
+        if(command.opcode != Opcode::Push && command.opcode != Opcode::Pop)
+            continue;
+        
+        if(command.segment == Segment::Argument)
+            callee.arguments = max(callee.arguments, command.index + 1);
+        else if(command.segment == Segment::Local && command.index >= callee.locals)
+            return false;
+        else if(command.segment == Segment::Pointer && command.opcode == Opcode::Pop)
+        {
+            if(command.index < 0 || command.index > 1)
+                return false;
+            callee.saves[command.index] = true;
+        }
+    }
+    
+    return true;
+}
+
+Inliner::Inliner(NameTable &names) : names(names)
+{
+}
+
+void Inliner::inlineCalls(vector<Module> &modules)
+{
+    // the functions of the program and the functions each calls
+    unordered_map<int, Callee> functions;
+    unordered_map<int, vector<int>> calls;
+    
+    for(size_t m = 0; m < modules.size(); m++)
+    {
+        const vector<Command> &commands = modules[m].commands;
+        
+        for(size_t i = 0; i < commands.size(); i++)
+        {
+            if(commands[i].opcode != Opcode::Function || functions.count(commands[i].name) > 0)
+                continue;
+            
+            size_t end = i + 1;
+            while(end < commands.size() && commands[end].opcode != Opcode::Function)
+                end++;
+            
+            Callee &callee = functions[commands[i].name];
+            callee.module = m;
+            callee.locals = commands[i].index;
+            callee.body.assign(commands.begin() + i + 1, commands.begin() + end);
+            
+            for(const Command &command : callee.body)
+                if(command.opcode == Opcode::Call)
+                    calls[commands[i].name].push_back(command.name);
+        }
+    }
+    
+    // those small enough that do not reach themselves through their calls
+    unordered_map<int, Callee> callees;
+    
+    for(auto &function : functions)
+    {
+        unordered_set<int> reached;
+        vector<int> pending(calls[function.first]);
+        
+        while(!pending.empty() && reached.count(function.first) == 0)
+        {
+            int next = pending.back();
+            pending.pop_back();
+            
+            if(reached.insert(next).second)
+                pending.insert(pending.end(), calls[next].begin(), calls[next].end());
+        }
+        
+        if(reached.count(function.first) == 0 && analyze(function.second.body, function.second))
+            callees.insert(function);
+    }
+    
+    for(size_t m = 0; m < modules.size(); m++)
+    {
+        vector<Command> &commands = modules[m].commands;
+        vector<Command> result;
+        result.reserve(commands.size());
+        
+        for(const Command &call : commands)
+        {
+            auto found = call.opcode == Opcode::Call ? callees.find(call.name) : callees.end();
+            
+            if(found == callees.end() || call.index < found->second.arguments)
+            {
+                result.push_back(call);
+                continue;
+            }
+            
+            const Callee &callee = found->second;
+            const string calleeName = names.get(call.name);
+            const string site = to_string(inlined.size());
+            
+            // the frame under the body: arguments, locals, then THIS and THAT when it sets them
+            int frame = call.index + callee.locals + callee.saves[0] + callee.saves[1];
+            
+            InlinedCall record{call, callee.locals, {}};
+            
+            auto emit = [&](Opcode opcode, Segment segment, int index, int name)
+            {
+                result.push_back(Command{opcode, segment, index, name, call.line});
+            };
+            
+            for(int i = 0; i < callee.locals; i++)
+                emit(Opcode::Push, Segment::Constant, 0, -1);
+            for(int p = 0; p < 2; p++)
+                if(callee.saves[p])
+                    emit(Opcode::Push, Segment::Pointer, p, -1);
+            
+            vector<Command> prologue(result.end() - (frame - call.index), result.end());
+            vector<Command> epilogue;
+            
+            const string &file = modules[callee.module].filename;
+            int statics = callee.module == m ? -1 : names.intern(file.substr(0, file.size() - 3));
+            int end = names.intern(calleeName + "$$" + site);
+            bool jumpsToEnd = false;
+            
+            for(size_t i = 0; i < callee.body.size(); i++)
+            {
+                Command command = callee.body[i];
+                int depth = callee.depths[i];
+                
+                // commands that never run are left out
+                if(depth < 0)
+                    continue;
+                
+                command.line = call.line;
+                
+                switch(command.opcode)
+                {
+                    case Opcode::Push:
+                    case Opcode::Pop:
+                    {
+                        // counted from the top left after a pop
+                        int top = frame + depth - (command.opcode == Opcode::Pop ? 1 : 0);
+                        
+                        if(command.segment == Segment::Argument)
+                        {
+                            command.segment = Segment::Stack;
+                            command.index = top - command.index;
+                        }
+                        else if(command.segment == Segment::Local)
+                        {
+                            command.segment = Segment::Stack;
+                            command.index = top - call.index - command.index;
+                        }
+                        else if(command.segment == Segment::Static)
+                            command.name = statics;
+                        
+                        result.push_back(command);
+                        break;
+                    }
+                    
+                    case Opcode::Label:
+                    case Opcode::Goto:
+                    case Opcode::If:
+                        command.name = names.intern(calleeName + "$" + names.get(command.name) + "$" + site);
+                        result.push_back(command);
+                        break;
+                    
+                    // restore THIS and THAT, move the value to where the first
+                    // argument was and drop the rest of the frame
+                    case Opcode::Return:
+                    {
+                        size_t begin = result.size();
+                        int saved = call.index + callee.locals;
+                        
+                        for(int p = 0; p < 2; p++)
+                            if(callee.saves[p])
+                            {
+                                emit(Opcode::Push, Segment::Stack, frame + depth - saved++, -1);
+                                emit(Opcode::Pop, Segment::Pointer, p, -1);
+                            }
+                        
+                        if(frame + depth > 1)
+                        {
+                            emit(Opcode::Pop, Segment::Stack, frame + depth - 1, -1);
+                            for(int i = 0; i < frame + depth - 2; i++)
+                                emit(Opcode::Pop, Segment::Constant, 0, -1);
+                        }
+                        
+                        epilogue.assign(result.begin() + begin, result.end());
+                        
+                        bool last = true;
+                        for(size_t j = i + 1; j < callee.body.size(); j++)
+                            last = last && callee.depths[j] < 0;
+                        
+                        if(!last)
+                        {
+                            emit(Opcode::Goto, Segment::None, 0, end);
+                            jumpsToEnd = true;
+                        }
+                        break;
+                    }
+                    
+                    default:
+                        result.push_back(command);
+                        break;
+                }
+            }
+            
+            if(jumpsToEnd)
+                emit(Opcode::Label, Segment::None, 0, end);
+            
+            record.frame = prologue;
+            record.frame.insert(record.frame.end(), epilogue.begin(), epilogue.end());
+            inlined.push_back(record);
+        }
+        
+        commands.swap(result);
+    }
+}
+
+const vector<InlinedCall> &Inliner::getInlined()
+{
+    return inlined;
+}
+
+// The instructions of the code of commands, which is straight-line code.
+// With trampolines, calls and returns run the shared routines, which are
+// straight-line code too, so their instructions are counted as well.
+static int measure(const vector<Command> &commands, const NameTable &names, const function<void(CodeWriter &)> &configure)
+{
+    ostringstream code;
+    CodeWriter writer(code);
+    configure(writer);
+    writer.setFilename("_.vm");
+    
+    for(const Command &command : commands)
+        writer.write(&command, 1, names);
+    
+    int count = CodeWriter::countInstructions(code.str());
+    size_t end = code.str().size();
+    
+    // the routines follow the loop that stops the program, each under a comment
+    writer.writeSubroutines();
+    size_t routines = code.str().find("\n// shared", end);
+    if(routines != string::npos)
+        count += CodeWriter::countInstructions(code.str().substr(routines));
+    
+    return count;
+}
+
+long Inliner::getSavedCycles(const function<void(CodeWriter &)> &configure)
+{
+    long cycles = 0;
+    
+    for(const InlinedCall &call : inlined)
+    {
+        vector<Command> protocol{
+            call.call,
+            Command{Opcode::Function, Segment::None, call.locals, call.call.name, call.call.line},
+            Command{Opcode::Return, Segment::None, 0, -1, call.call.line}
+        };
+        cycles += measure(protocol, names, configure) - measure(call.frame, names, configure);
+    }
+    
+    return cycles;
+}
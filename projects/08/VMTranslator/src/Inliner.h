@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Interface of the Inliner module: inlining of small VM functions.
+ */
+
+#ifndef INLINER_H
+#define INLINER_H
+
+#include "CodeWriter.h"
+#include "Command.h"
+
+#include <functional>
+#include <vector>
+
+// A call replaced by the body of the function it called
+struct InlinedCall
+{
+    Command call;
+    int locals;
+    
+    // what runs in place of the call, function and return commands: the
+    // frame of the body set up and torn down
+    std::vector<Command> frame;
+};
+
+// Replaces calls to small functions that do not reach themselves with their
+// bodies, across the whole program. Arguments and locals live in the stack
+// slots under the body and are reached through the stack segment, labels
+// are renamed per call, and THIS and THAT are kept for the caller when the
+// body sets them.
+class Inliner
+{
+public:
+    Inliner(NameTable &names);
+    
+    // inlines the calls of every module; once, before they are written
+    void inlineCalls(std::vector<Module> &modules);
+    
+    const std::vector<InlinedCall> &getInlined();
+    
+    // the cycles of the call, function and return commands the inlined calls
+    // no longer run, less those of their frames, in code written by writers
+    // set up by configure
+    long getSavedCycles(const std::function<void(CodeWriter &)> &configure);
+    
+private:
+    NameTable &names;
+    std::vector<InlinedCall> inlined;
+};
+
+#endif // INLINER_H
@@ -28,16 +28,163 @@
 
 #include "Parser.h"
 
-#include <istream>
-#include <string>
 #include <cctype>
+#include <cstring>
+#include <istream>
+#include <iterator>
 #include <stdexcept>
-#include <regex>
-#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 
-Parser::Parser(istream& inputStream) : input{inputStream}, type{CommandType::Unknown}, line_no{1}, arg1{""}, arg2{""}
+// A command keyword and what it parses to
+struct Keyword
+{
+    const char *text;
+    CommandType type;
+    Opcode opcode;
+};
+
+// Keywords by a perfect hash of their first two characters and length
+const int KEYWORD_SLOTS{32};
+
+static inline int keywordSlot(const char *word, size_t length)
+{
+    return (word[0] * 12 + word[1] * 25 + static_cast<int>(length)) & (KEYWORD_SLOTS - 1);
+}
+
+// Segments by a perfect hash of their first and last characters and length
+const int SEGMENT_SLOTS{16};
+
+static inline int segmentSlot(const char *word, size_t length)
+{
+    return (word[0] + word[length - 1] * 2 + static_cast<int>(length)) & (SEGMENT_SLOTS - 1);
+}
+
+static const Keyword *findKeyword(const string &word)
+{
+    static const Keyword keywords[]{
+        {"add", CommandType::Arithmetic, Opcode::Add}, {"sub", CommandType::Arithmetic, Opcode::Sub},
+        {"neg", CommandType::Arithmetic, Opcode::Neg}, {"eq", CommandType::Arithmetic, Opcode::Eq},
+        {"gt", CommandType::Arithmetic, Opcode::Gt}, {"lt", CommandType::Arithmetic, Opcode::Lt},
+        {"and", CommandType::Arithmetic, Opcode::And}, {"or", CommandType::Arithmetic, Opcode::Or},
+        {"not", CommandType::Arithmetic, Opcode::Not}, {"push", CommandType::Push, Opcode::Push},
+        {"pop", CommandType::Pop, Opcode::Pop}, {"label", CommandType::Label, Opcode::Label},
+        {"goto", CommandType::Goto, Opcode::Goto}, {"if-goto", CommandType::If, Opcode::If},
+        {"function", CommandType::Function, Opcode::Function}, {"call", CommandType::Call, Opcode::Call},
+        {"return", CommandType::Return, Opcode::Return}
+    };
+    
+    static const vector<const Keyword *> table = []() {
+        vector<const Keyword *> slots(KEYWORD_SLOTS);
+        for(const Keyword &keyword : keywords)
+            slots[keywordSlot(keyword.text, strlen(keyword.text))] = &keyword;
+        return slots;
+    }();
+    
+    // every command word has at least two characters
+    const Keyword *candidate = table[keywordSlot(word.data(), word.size())];
+    
+    return candidate && word == candidate->text ? candidate : nullptr;
+}
+
+static bool findSegment(const string &word, Segment &segment)
+{
+    static const Segment segments[]{Segment::Constant, Segment::Local, Segment::Argument, Segment::This,
+                                    Segment::That, Segment::Pointer, Segment::Temp, Segment::Static};
+    
+    static const vector<Segment> table = []() {
+        vector<Segment> slots(SEGMENT_SLOTS, Segment::None);
+        for(Segment candidate : segments)
+            slots[segmentSlot(segmentName(candidate), strlen(segmentName(candidate)))] = candidate;
+        return slots;
+    }();
+    
+    if(word.empty())
+        return false;
+    
+    segment = table[segmentSlot(word.data(), word.size())];
+    
+    return segment != Segment::None && word == segmentName(segment);
+}
+
+// The characters of a name after its first: letters, digits and _ : .
+static inline bool isNameChar(char ch)
+{
+    return isalnum(static_cast<unsigned char>(ch)) || ch == '_' || ch == ':' || ch == '.';
+}
+
+static inline bool isSpace(char ch)
+{
+    return isspace(static_cast<unsigned char>(ch)) != 0;
+}
+
+static bool isNumber(const char *begin, const char *end)
+{
+    for(const char *p = begin; p != end; p++)
+        if(!isdigit(static_cast<unsigned char>(*p)))
+            return false;
+    
+    return begin != end;
+}
+
+// A command word: a non-digit and then at least one name character or '-'
+static bool validKeyword(const char *begin, const char *end)
+{
+    if(end - begin < 2 || isdigit(static_cast<unsigned char>(*begin)))
+        return false;
+    
+    for(const char *p = begin + 1; p != end; p++)
+        if(!isNameChar(*p) && *p != '-')
+            return false;
+    
+    return true;
+}
+
+// An argument: a number, or a non-digit and then name characters
+static bool validArgument(const char *begin, const char *end)
+{
+    if(isNumber(begin, end))
+        return true;
+    
+    if(isdigit(static_cast<unsigned char>(*begin)) || (end - begin == 1 && !isNameChar(*begin)))
+        return false;
+    
+    for(const char *p = begin + 1; p != end; p++)
+        if(!isNameChar(*p))
+            return false;
+    
+    return true;
+}
+
+// The end of the line starting at text, or end when it is the last
+static const char *findNewline(const char *text, const char *end)
+{
+#ifdef __SSE2__
+    const __m128i newline = _mm_set1_epi8('\n');
+    
+    for(; end - text >= 16; text += 16)
+    {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chars, newline));
+        
+        if(mask)
+            return text + __builtin_ctz(mask);
+    }
+#endif
+    
+    const char *found = static_cast<const char *>(memchr(text, '\n', end - text));
+    return found ? found : end;
+}
+
+Parser::Parser(istream& inputStream) :
+    buffer(istreambuf_iterator<char>(inputStream), istreambuf_iterator<char>()), position{0},
+    type{CommandType::Unknown}, opcode{Opcode::Return}, line_no{1}, arg1{""}, arg2{""}
 {
 }
 
@@ -45,23 +192,34 @@ bool Parser::hasMoreCommands()
 {
     skipComments();
     
-    return !input.eof();
+    return position < buffer.size();
 }
 
 void Parser::advance()
 {
-    // Get the line
-    string line;
+    const char *text = buffer.data();
+    const char *begin = text + position;
+    const char *end = findNewline(begin, text + buffer.size());
     
-    getline(input, line);
+    position = min(static_cast<size_t>(end - text) + 1, buffer.size());
     
     // Strip comments and trim
-    string command = stripLine(line);
+    for(const char *p = begin; p + 1 < end; p++)
+        if(p[0] == '/' && p[1] == '/')
+        {
+            end = p;
+            break;
+        }
+    
+    while(begin != end && isSpace(*begin))
+        begin++;
+    while(end != begin && isSpace(end[-1]))
+        end--;
     
-    if(command.size() == 0)
+    if(begin == end)
         throw runtime_error("Could not parse line. Check syntax.");
 
-    parseCommmand(command);
+    parseCommmand(begin, end);
     
     line_no++;
 }
@@ -89,175 +247,176 @@ int Parser::getLineNumber()
 
 void Parser::skipComments()
 {
+    const char *text = buffer.data();
+    size_t size = buffer.size();
+    
     // Keep getting the next character, skipping whitespace
-    while(input && !input.eof())
+    while(position < size)
     {
-        char ch;
-        
-        input.get(ch);
-        
-        if(input.eof())
-            break;
-        
-        // Keep track of newlines
-        if(ch == '\n')
-            line_no++;
-        
-        if(isspace(ch))
-            continue;
+        char ch = text[position];
         
-        string ignore;
+        if(isSpace(ch))
+        {
+            // Keep track of newlines
+            if(ch == '\n')
+                line_no++;
+            
+            position++;
+        }
         
         // If the next character is a comment, skip the line
-        if(ch == '/' && input.peek() == '/') 
+        else if(ch == '/' && position + 1 < size && text[position + 1] == '/')
         {
-            getline(input, ignore);
+            position = findNewline(text + position, text + size) - text;
+            position = min(position + 1, size);
             line_no++;
         }
         
-       // Otherwise place it back in the stream and exit
+        // Otherwise it starts a command
         else
-        {
-            input.putback(ch);
             break;
-        }
     }
 }
 
-bool isArithmetic(const string &s)
-{
-	return (s == "add" || s == "sub" || s == "neg" || s == "eq" ||
-		s == "gt" || s == "lt" || s == "and" || s == "or" || s == "not");
-}
-
-bool isMemoryAccess(const string &s)
-{
-	return (s == "push" || s == "pop");
-}
-
-bool isFlow(const string &s)
-{
-	return (s == "label" || s == "goto" || s == "if-goto");
-}
-
-bool isFunctionCall(const string &s)
+void Parser::parseCommmand(const char *begin, const char *end)
 {
-	return (s == "function" || s == "call" || s == "return");
-}
-
-bool validLabel(const string &s)
-{
-    static const std::string command_expresssion = R"(^(\s*\D[\w\:_\.]+)$)";
-    static const regex e{command_expresssion};
+    // split into at most three words; a fourth does not parse
+    const char *words[3][2];
+    int count = 0;
     
-    smatch matches;
-    regex_match(s, matches, e);
+    for(const char *p = begin; p != end; )
+    {
+        if(count == 3)
+        {
+            type = CommandType::Unknown;
+            throw runtime_error("Could not parse command. Check syntax.");
+        }
+        
+        words[count][0] = p;
+        while(p != end && !isSpace(*p))
+            p++;
+        words[count][1] = p;
+        count++;
+        
+        while(p != end && isSpace(*p))
+            p++;
+    }
     
-    return matches.size() > 1;
-}
-
-void Parser::parseCommmand(const string &command)
-{
-    static const std::string command_expresssion = R"(^(\D[\w\:_\.\-]+)(\s*(?:\D[\w\:_\.]+|\d+))?(\s*(?:\D[\w\:_\.]+|\d+))?$)";
-    static const regex e{command_expresssion};
+    if(!validKeyword(words[0][0], words[0][1]) ||
+       (count > 1 && !validArgument(words[1][0], words[1][1])) ||
+       (count > 2 && !validArgument(words[2][0], words[2][1])))
+    {
+        type = CommandType::Unknown;
+        throw runtime_error("Could not parse command. Check syntax.");
+    }
     
-    smatch matches;
-    regex_match(command, matches, e);
+    // the command parses; its arguments are kept even when it is not valid
+    string command(words[0][0], words[0][1]);
+    arg1.assign(count > 1 ? words[1][0] : end, count > 1 ? words[1][1] : end);
+    arg2.assign(count > 2 ? words[2][0] : end, count > 2 ? words[2][1] : end);
     
-    // cout << command << endl;
+    const Keyword *keyword = findKeyword(command);
     
-    if(matches.size() > 1)
+    if(!keyword)
     {
-        // match found; parse command
-        arg1 = trim(matches[2]);
-        arg2 = trim(matches[3]);
-        
-        if(isArithmetic(matches[1]))
-        {
-            if(matches[2] != "")
+        type = CommandType::Unknown;
+        throw runtime_error("Could not parse command. Check syntax.");
+    }
+    
+    switch(keyword->type)
+    {
+        case CommandType::Arithmetic:
+            if(count > 1)
             {
                 type = CommandType::Unknown;
-                throw runtime_error("Could not parse arithmetic command. Check syntax.");;
-            }            
-            else
-            {
-                type = CommandType::Arithmetic;
-                arg1 = matches[1];
-                arg2 = "";
+                throw runtime_error("Could not parse arithmetic command. Check syntax.");
             }
-        }
-        else if(isMemoryAccess(matches[1]))
-        {
-            if(matches[3] == "")
+            arg1 = command;
+            arg2 = "";
+            break;
+        
+        case CommandType::Push:
+        case CommandType::Pop:
+            if(count < 3)
             {
                 type = CommandType::Unknown;
                 throw runtime_error("Could not parse memory access command. Check syntax.");
             }
-            else
-            {
-                if(matches[1] == "push")
-                    type = CommandType::Push;
-                else
-                    type = CommandType::Pop;
-            }
-            
-        }
-        else if(isFlow(matches[1]))
-        {
-            if(matches[3] != "" || !validLabel(matches[2]))
+            break;
+        
+        case CommandType::Label:
+        case CommandType::Goto:
+        case CommandType::If:
+            if(count != 2)
             {
                 type = CommandType::Unknown;
                 throw runtime_error("Could not parse flow command. Check syntax.");
             }
-            else
-            {
-                if(matches[1] == "label")
-                    type = CommandType::Label;
-                else if(matches[1] == "goto")
-                    type = CommandType::Goto;
-                else
-                    type = CommandType::If;
-            }
-        }
-        else if(isFunctionCall(matches[1]))
-        {
-            if(matches[1] == "function" && validLabel(matches[2]))
-                type = CommandType::Function;
-            else if(matches[1] == "call" && validLabel(matches[2]))
-                type = CommandType::Call;
-            else if(matches[1] == "return" && matches[2] == "")
-                type = CommandType::Return;
-            else
+            break;
+        
+        default:
+            // function and call take a name, return takes nothing
+            if((keyword->type == CommandType::Return) != (count == 1))
             {
                 type = CommandType::Unknown;
                 throw runtime_error("Could not parse function-call command. Check syntax.");
             }
-        }
-        else
-        {
-            type = CommandType::Unknown;
-            throw runtime_error("Could not parse command. Check syntax.");
-        }
+            break;
+    }
+    
+    type = keyword->type;
+    opcode = keyword->opcode;
+}
+
+static int integer(const string &s)
+{
+    try
+    {
+        return stoi(s);
     }
-    else
+    catch(invalid_argument &e)
     {
-        type = CommandType::Unknown;
-        throw runtime_error("Could not parse command. Check syntax.");
+        throw runtime_error("Could not convert '" + s + "' to integer");
+    }
+    catch(out_of_range &e)
+    {
+        throw runtime_error("'" + s + "' does not fit in an integer");
     }
 }
 
-
-string Parser::stripLine(const string &line)
+Command Parser::getCommand(NameTable &names)
 {
-    string str{line};
+    // line_no has moved past the command by now
+    Command command{opcode, Segment::None, 0, -1, line_no - 1};
     
-    // Strip comment to end
-    for(int  i = 0; i < line.size() - 1; i++)
-        if(line[i] == '/' && line[i+1] == '/')
-        {
-            str = line.substr(0, i);
+    switch(type)
+    {
+        case CommandType::Arithmetic:
+        case CommandType::Return:
             break;
-        }
+        
+        case CommandType::Push:
+        case CommandType::Pop:
+            if(!findSegment(arg1, command.segment))
+                throw runtime_error(string(type == CommandType::Push ? "Push" : "Pop") + " command: '" + arg1 + "' not a valid segment");
+            command.index = integer(arg2);
+            break;
+        
+        case CommandType::Label:
+        case CommandType::Goto:
+        case CommandType::If:
+            command.name = names.intern(arg1);
+            break;
+        
+        case CommandType::Function:
+        case CommandType::Call:
+            command.name = names.intern(arg1);
+            command.index = integer(arg2);
+            break;
+        
+        default:
+            throw runtime_error("Unrecognized command");
+    }
     
-    return trim(str);
+    return command;
 }
@@ -29,12 +29,14 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include "Command.h"
 #include "Common.h"
 
 #include <string>
 #include <istream>
 
-// Refer to the API documentation in chapter 7
+// Refer to the API documentation in chapter 7. The whole input is read into
+// memory up front and scanned in place, a line at a time.
 class Parser
 {
 public:
@@ -46,16 +48,20 @@ public:
     std::string getArg2();
     int getLineNumber();
     
+    // the command just parsed in its typed form, with its names interned
+    Command getCommand(NameTable &names);
+    
 private:
-    std::istream &input;
+    std::string buffer;
+    size_t position;
     CommandType type;
+    Opcode opcode;
     int line_no;
     std::string arg1;
     std::string arg2;
     
     void skipComments();
-    void parseCommmand(const std::string &command);
-    std::string stripLine(const std::string &line);
+    void parseCommmand(const char *begin, const char *end);
 };
 
 #endif // PARSER_H
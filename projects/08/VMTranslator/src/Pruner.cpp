@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of the Pruner module.
+ */
+
+#include "Pruner.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+// Where a function is defined: its module and the span of its commands,
+// the function command included
+struct Definition
+{
+    size_t module;
+    size_t begin;
+    size_t end;
+};
+
+Pruner::Pruner(const NameTable &names) : names(names), removed{0}
+{
+}
+
+void Pruner::prune(vector<Module> &modules)
+{
+    int init = names.find("Sys.init");
+    
+    unordered_map<int, Definition> functions;
+    
+    for(size_t m = 0; m < modules.size(); m++)
+    {
+        const vector<Command> &commands = modules[m].commands;
+        
+        for(size_t i = 0; i < commands.size(); i++)
+        {
+            if(commands[i].opcode != Opcode::Function)
+                continue;
+            
+            size_t end = i + 1;
+            while(end < commands.size() && commands[end].opcode != Opcode::Function)
+                end++;
+            
+            functions.emplace(commands[i].name, Definition{m, i, end});
+        }
+    }
+    
+    if(functions.count(init) == 0)
+        return;
+    
+    // follow the calls from Sys.init
+    unordered_set<int> reached{init};
+    vector<int> pending{init};
+    
+    while(!pending.empty())
+    {
+        const Definition &definition = functions.at(pending.back());
+        pending.pop_back();
+        
+        const vector<Command> &commands = modules[definition.module].commands;
+        
+        for(size_t i = definition.begin; i < definition.end; i++)
+            if(commands[i].opcode == Opcode::Call && functions.count(commands[i].name) > 0 && reached.insert(commands[i].name).second)
+                pending.push_back(commands[i].name);
+    }
+    
+    // keep what is outside functions and the functions reached
+    for(Module &module : modules)
+    {
+        vector<Command> kept;
+        kept.reserve(module.commands.size());
+        bool keeping = true;
+        
+        for(const Command &command : module.commands)
+        {
+            if(command.opcode == Opcode::Function)
+            {
+                keeping = reached.count(command.name) > 0;
+                removed += !keeping;
+            }
+            
+            if(keeping)
+                kept.push_back(command);
+        }
+        
+        module.commands.swap(kept);
+    }
+}
+
+int Pruner::getRemoved()
+{
+    return removed;
+}
@@ -26,7 +26,10 @@
 /* Entry point and facade controller of the translator
  */
 #include "Translator.h"
+#include "Folder.h"
+#include "Inliner.h"
 #include "Parser.h"
+#include "Pruner.h"
 
 #define BOOST_FILESYSTEM_NO_DEPRECATED
 #include <boost/filesystem.hpp>
@@ -34,170 +37,201 @@
 #include <iostream>
 #include <fstream>
 #include <exception>
+#include <sstream>
 
 using namespace std;
 using namespace boost::filesystem;
 
 const string OUTPUT_PREFIX("asm");
 
-Translator::Translator(vector<string> arguments)
+const string USAGE("Usage: VMTranslator [--peephole] [--trampolines] [--shared-comparisons] [--cache-stack] [--fold] [--inline] [--prune] [--stats] <file.vm | directory>");
+
+Translator::Translator(vector<string> arguments) : peephole{false}, trampolines{false}, sharedComparisons{false}, stackCaching{false}, folding{false}, inlining{false}, pruning{false}, stats{false}
 {
-    if(arguments.size() != 2)
-        throw runtime_error("Error: Program only takes 1 argument");
+    for(size_t i = 1; i < arguments.size(); i++)
+    {
+        if(arguments[i] == "--peephole")
+            peephole = true;
+        else if(arguments[i] == "--trampolines")
+            trampolines = true;
+        else if(arguments[i] == "--shared-comparisons")
+            sharedComparisons = true;
+        else if(arguments[i] == "--cache-stack")
+            stackCaching = true;
+        else if(arguments[i] == "--fold")
+            folding = true;
+        else if(arguments[i] == "--inline")
+            inlining = true;
+        else if(arguments[i] == "--prune")
+            pruning = true;
+        else if(arguments[i] == "--stats")
+            stats = true;
+        else if(arguments[i].compare(0, 2, "--") == 0)
+            throw runtime_error("Error: Unknown option '" + arguments[i] + "'. " + USAGE);
+        else if(inputFilename.empty())
+            inputFilename = arguments[i];
+        else
+            throw runtime_error("Error: Program only takes 1 file or directory. " + USAGE);
+    }
     
-    inputFilename = arguments[1];
+    if(inputFilename.empty())
+        throw runtime_error("Error: " + USAGE);
 }
 
-void Translator::translate(string inputFilename, CodeWriter &writer)
+
+void Translator::parse(string inputFilename)
 {
     // prepare file for parsing
     std::ifstream input(inputFilename);    
     Parser parser(input);
     
-    writer.setFilename(path(inputFilename).filename().string());
+    modules.push_back(Module{path(inputFilename).filename().string(), {}});
+    vector<Command> &commands = modules.back().commands;
     
-    try
+    // while there is more to parse
+    for(;;)
     {
-        // while there is more to parse
-        while(parser.hasMoreCommands())
+        try
         {
-            // parse it
-            parser.advance();
-            
-            CommandType type = parser.getCommandType();
-            
-            writer.writeAnnotation(type, parser.getArg1(), parser.getArg2());
+            if(!parser.hasMoreCommands())
+                break;
             
-            // write the correct command
-            switch(type)
-            {
-                case CommandType::Label:
-                {
-                    writer.writeLabel(parser.getArg1());
-                    break;
-                }
-                
-                case CommandType::Goto:
-                {
-                    writer.writeGoto(parser.getArg1());
-                    break;
-                }
-                
-                case CommandType::If:
-                {
-                    writer.writeIf(parser.getArg1());
-                    break;
-                }
-                
-                case CommandType::Call:
-                {
-                    int args = stoi(parser.getArg2());
-                    writer.writeCall(parser.getArg1(), args);
-                    break;
-                }
-                
-                case CommandType::Function:
-                {
-                    int args = stoi(parser.getArg2());
-                    writer.writeFunction(parser.getArg1(), args);
-                    break;
-                }
-                
-                case CommandType::Return:
-                {
-                    writer.writeReturn();
-                    break;
-                }
-                
-                case CommandType::Arithmetic:
-                {
-                    writer.writeArithmetic(parser.getArg1());
-                    break;
-                }
-                
-                case CommandType::Push:
-                case CommandType::Pop:
-                {
-                    try
-                    {
-                        int index = stoi(parser.getArg2());
-                        writer.writePushPop(type, parser.getArg1(), index);
-                    }
-                    catch(invalid_argument &e)
-                    {
-                        throw runtime_error("Could not convert '" + parser.getArg2() + "' to integer");
-                    }
-                    catch(out_of_range &e)
-                    {
-                        throw runtime_error("'" + parser.getArg2() + "' does not fit in an integer");
-                    }
-                    
-                    break;
-                }
-                
-                default:
-                {
-                    throw runtime_error("Unrecognized command");
-                    break;
-                }
-            }
+            parser.advance();
+        }
+        catch(runtime_error &e)
+        {
+            throw runtime_error(inputFilename + " (" + to_string(parser.getLineNumber()) + "): " + e.what());
+        }
+        
+        // the parser has moved on to the next line by now
+        try
+        {
+            commands.push_back(parser.getCommand(names));
+        }
+        catch(runtime_error &e)
+        {
+            throw runtime_error(inputFilename + " (" + to_string(parser.getLineNumber() - 1) + "): " + e.what());
         }
-    }
-    catch(runtime_error &e)
-    {
-        throw runtime_error(inputFilename + " (" + to_string(parser.getLineNumber()) + "): " + e.what());
     }
 }
 
-void Translator::run()
+void Translator::write(CodeWriter &writer)
 {
-    // if the file is a directory, parse and translate all .vm files
-    if(is_directory(inputFilename))
+    // programs without a Sys.init are run from their first command, as the tests of chapter 7 do
+    int init = names.find("Sys.init");
+    bool hasInit = false;
+    
+    for(const Module &module : modules)
+        for(const Command &command : module.commands)
+            hasInit = hasInit || (command.opcode == Opcode::Function && command.name == init);
+    
+    if(hasInit)
+        writer.writeInit();
+    
+    for(const Module &module : modules)
     {
-        string outputFilename = path(inputFilename).filename().string() + "." + OUTPUT_PREFIX;
-        std::ofstream out(outputFilename);
-        CodeWriter cw(out);
+        writer.setFilename(module.filename);
         
-        bool empty = true;
+        const vector<Command> &commands = module.commands;
         
-        cw.writeInit();
-        
-        for(auto&& f : directory_iterator(path(inputFilename)))
+        for(size_t i = 0; i < commands.size(); )
         {
-            if(is_vm(f.path().filename().string()))
+            try
+            {
+                i += writer.write(&commands[i], commands.size() - i, names);
+            }
+            catch(runtime_error &e)
             {
-                empty = false;
-                string input_name = path(f).string();
-                translate(input_name, cw);
+                throw runtime_error(module.filename + " (" + to_string(commands[i].line) + "): " + e.what());
             }
         }
+    }
+    
+    writer.writeSubroutines();
+}
+
+void Translator::configure(CodeWriter &writer)
+{
+    writer.setPeephole(peephole);
+    writer.setTrampolines(trampolines);
+    writer.setSharedComparisons(sharedComparisons);
+    writer.setStackCaching(stackCaching);
+}
+
+// The calls inlined and the cycles of the call protocol they no longer run
+void Translator::reportInlining(Inliner &inliner)
+{
+    long cycles = inliner.getSavedCycles([this](CodeWriter &writer) { configure(writer); });
+    
+    cout << inliner.getInlined().size() << " call sites inlined, saving " << cycles << " cycles when each runs once" << endl;
+}
+
+void Translator::run()
+{
+    string outputFilename;
+    
+    // if the file is a directory, parse all .vm files
+    if(is_directory(inputFilename))
+    {
+        for(auto&& f : directory_iterator(path(inputFilename)))
+            if(is_vm(f.path().filename().string()))
+                parse(path(f).string());
         
-        if(empty)
-        {
-            out.close();
-            remove(outputFilename);
+        if(modules.empty())
             throw runtime_error("Error: Directory '" + inputFilename + "' has no .vm files");
-        }
+        
+        outputFilename = path(inputFilename).filename().string() + "." + OUTPUT_PREFIX;
     }
-    // otherwise, if the file is a regular file, make sure it's a vm file and translate it
+    // otherwise, if the file is a regular file, make sure it's a vm file and parse it
     else if(is_regular_file(inputFilename))
     {
         if(is_vm(path(inputFilename).filename().string()))
-        {
-            std::ofstream out(path(inputFilename).filename().stem().string() + + "." + OUTPUT_PREFIX);
-            CodeWriter cw(out);
-            
-            cw.writeInit();
-            
-            translate(inputFilename, cw);
-        }
+            parse(inputFilename);
         else
             throw runtime_error("Error: '" + inputFilename + "' does not end in a .vm extension");
+        
+        outputFilename = path(inputFilename).filename().stem().string() + "." + OUTPUT_PREFIX;
     }
     // otherwise it's not a supported file
     else
         throw runtime_error("Error: '" + inputFilename + "' is not a .vm file or directory");
-        
+    
+    // the whole program is parsed, inlined, pruned and folded before any code
+    // is written; pruning after inlining drops the functions inlined everywhere
+    Inliner inliner(names);
+    if(inlining)
+        inliner.inlineCalls(modules);
+    
+    Pruner pruner(names);
+    if(pruning)
+        pruner.prune(modules);
+    
+    Folder folder;
+    if(folding)
+        for(Module &module : modules)
+            folder.fold(module.commands);
+    
+    ostringstream code;
+    CodeWriter cw(code);
+    configure(cw);
+    
+    write(cw);
+    
+    std::ofstream out(outputFilename);
+    out << code.str();
+    
+    if(stats)
+    {
+        cout << CodeWriter::countInstructions(code.str()) << " instructions" << endl;
+        if(peephole)
+            cout << cw.getRewrites() << " command sequences rewritten by the peephole optimizer" << endl;
+        if(folding)
+            cout << folder.getFolds() << " constant folds" << endl;
+        if(inlining)
+            reportInlining(inliner);
+        if(pruning)
+            cout << pruner.getRemoved() << " unreachable functions removed" << endl;
+    }
 }
 
 int main(int argc, char *argv[])
@@ -30,6 +30,8 @@
 #define TRANSLATOR_H
 
 #include "CodeWriter.h"
+#include "Command.h"
+#include "Inliner.h"
 
 #include <string>
 #include <vector>
@@ -42,13 +44,32 @@ public:
         
 private:
     std::string inputFilename;
+    bool peephole;
+    bool trampolines;
+    bool sharedComparisons;
+    bool stackCaching;
+    bool folding;
+    bool inlining;
+    bool pruning;
+    bool stats;
+    NameTable names;
+    std::vector<Module> modules;
     
     inline bool is_vm(std::string filename)
     {
         return filename.substr(filename.length() - 3, 3) == ".vm";
     }
     
-    void translate(std::string inputFilename, CodeWriter& writer);
+    // parses a .vm file into a module of commands
+    void parse(std::string inputFilename);
+    
+    // writes the code of every module, with the bootstrap when there is a Sys.init to call
+    void write(CodeWriter &writer);
+    
+    // sets a CodeWriter up with the options of the program
+    void configure(CodeWriter &writer);
+    
+    void reportInlining(Inliner &inliner);
 };
 
 #endif // TRANSLATOR_H
@@ -29,9 +29,11 @@
 
 #include <fstream>
 #include <iterator>
+#include <sstream>
 #include <string>
 #include <algorithm>
 #include <stdexcept>
+#include <vector>
 
 // https://stackoverflow.com/questions/6163611/compare-two-files
 bool compareFiles(const std::string& p1, const std::string& p2) {
@@ -75,6 +77,19 @@ public:
    }
 };
 
+// generated code without the comment lines annotating its commands
+static string withoutAnnotations(const string &code)
+{
+    string result;
+    istringstream lines(code);
+    
+    for(string line; getline(lines, line); )
+        if(line.compare(0, 3, "\t//") != 0)
+            result += line + "\n";
+    
+    return result;
+}
+
 // valid output
 TEST(CodeWriterTest, TestValidOutput_writeInit)
 {
@@ -175,3 +190,172 @@ TEST(CodeWriterTest, TestValidOutput_writeReturn)
     out.close();
     ASSERT_TRUE(compareFiles("CodeWriter/writeReturn_out", "CodeWriter/writeReturn_expected"));
 }
+
+// push then pop moves the word without the stack
+TEST(CodeWriterTest, TestPushPop_peephole)
+{
+    NameTable names;
+    vector<Command> commands{
+        {Opcode::Push, Segment::Local, 0, -1, 1},
+        {Opcode::Pop, Segment::Static, 3, -1, 2},
+        {Opcode::Push, Segment::Constant, 1, -1, 3},
+        {Opcode::Add, Segment::None, 0, -1, 4}
+    };
+    
+    ostringstream out;
+    CodeWriterWrapper cw(out);
+    cw.setFilename("Main.vm");
+    cw.setPeephole(true);
+    
+    ASSERT_EQ(cw.write(&commands[0], commands.size(), names), 2u);
+    ASSERT_EQ(out.str().find("@SP"), string::npos);
+    ASSERT_NE(out.str().find("@Main.3\n\tM=D\n"), string::npos);
+    
+    ASSERT_EQ(cw.write(&commands[2], 2, names), 2u);
+    ASSERT_NE(out.str().find("\t@SP\n\tA=M-1\n\tM=M+1\n"), string::npos);
+    ASSERT_EQ(cw.getRewrites(), 2);
+}
+
+// without the peephole optimizer, or without a pattern, one command at a time
+TEST(CodeWriterTest, TestNoPattern_peephole)
+{
+    NameTable names;
+    vector<Command> commands{
+        {Opcode::Push, Segment::Local, 0, -1, 1},
+        {Opcode::Pop, Segment::Static, 3, -1, 2},
+        {Opcode::Push, Segment::Temp, 9, -1, 3},
+        {Opcode::Pop, Segment::Local, 0, -1, 4}
+    };
+    
+    ostringstream out;
+    CodeWriterWrapper cw(out);
+    cw.setFilename("Main.vm");
+    
+    ASSERT_EQ(cw.write(&commands[0], commands.size(), names), 1u);
+    
+    // an index out of range is still reported
+    cw.setPeephole(true);
+    ASSERT_THROW(cw.write(&commands[2], 2, names), runtime_error);
+}
+
+// calls and returns jump to routines written once, after the last command
+TEST(CodeWriterTest, TestTrampolines_writeSubroutines)
+{
+    ostringstream out;
+    CodeWriterWrapper cw(out);
+    cw.setTrampolines(true);
+    
+    cw.writeCall("my_foo", 2);
+    cw.writeReturn();
+    ASSERT_EQ(out.str(), "\t@2\n\tD=A\n\t@R14\n\tM=D\n\t@my_foo\n\tD=A\n\t@R13\n\tM=D\n\t@ret_0\n\tD=A\n\t@$call\n\t0;JMP\n(ret_0)\n"
+                         "\t@$return\n\t0;JMP\n");
+    
+    cw.writeSubroutines();
+    ASSERT_NE(out.str().find("($call)\n"), string::npos);
+    ASSERT_NE(out.str().find("($return)\n"), string::npos);
+    
+    // each routine is written once
+    size_t length = out.str().size();
+    cw.writeSubroutines();
+    ASSERT_EQ(out.str().size(), length);
+}
+
+// comparisons jump to a routine of their own, written only when used
+TEST(CodeWriterTest, TestSharedComparisons_writeSubroutines)
+{
+    ostringstream out;
+    CodeWriterWrapper cw(out);
+    cw.setSharedComparisons(true);
+    
+    cw.writeArithmetic(Opcode::Lt);
+    cw.writeArithmetic(Opcode::Lt);
+    ASSERT_EQ(out.str(), "\t@ret_0\n\tD=A\n\t@$lt\n\t0;JMP\n(ret_0)\n\t@ret_1\n\tD=A\n\t@$lt\n\t0;JMP\n(ret_1)\n");
+    
+    cw.writeSubroutines();
+    ASSERT_NE(out.str().find("($lt)\n"), string::npos);
+    ASSERT_NE(out.str().find("\tD;JLT\n"), string::npos);
+    ASSERT_EQ(out.str().find("($eq)\n"), string::npos);
+    ASSERT_EQ(out.str().find("($call)\n"), string::npos);
+}
+
+// the top of the stack stays in D until a label needs the stack in memory
+TEST(CodeWriterTest, TestStackCaching_write)
+{
+    NameTable names;
+    vector<Command> commands{
+        {Opcode::Push, Segment::Constant, 7, -1, 1},
+        {Opcode::Push, Segment::Constant, 1, -1, 2},
+        {Opcode::Add, Segment::None, 0, -1, 3},
+        {Opcode::Neg, Segment::None, 0, -1, 4},
+        {Opcode::Label, Segment::None, 0, names.intern("LOOP"), 5}
+    };
+    
+    ostringstream out;
+    CodeWriterWrapper cw(out);
+    cw.setFilename("Main.vm");
+    cw.setStackCaching(true);
+    
+    for(size_t i = 0; i < commands.size(); i++)
+        ASSERT_EQ(cw.write(&commands[i], commands.size() - i, names), 1u);
+    
+    string code = withoutAnnotations(out.str());
+    
+    size_t label = out.str().find("(_$LOOP)\n");
+    ASSERT_NE(label, string::npos);
+    ASSERT_NE(code.find("\t@7\n\tD=A\n\t@SP\n\tAM=M+1\n\tA=A-1\n\tM=D\n\tD=1\n\t@SP\n\tAM=M-1\n\tD=D+M\n\tD=-D\n"
+                        "\t@SP\n\tAM=M+1\n\tA=A-1\n\tM=D\n(_$LOOP)\n"), string::npos);
+    
+    // nothing is left cached to write at the end
+    cw.writeSubroutines();
+    ASSERT_EQ(out.str().find("\t@SP\n", label), string::npos);
+}
+
+// a comparison tested by if-goto jumps on the difference, without a boolean
+TEST(CodeWriterTest, TestCompareAndBranch_peephole)
+{
+    NameTable names;
+    vector<Command> commands{
+        {Opcode::Lt, Segment::None, 0, -1, 1},
+        {Opcode::Not, Segment::None, 0, -1, 2},
+        {Opcode::If, Segment::None, 0, names.intern("END"), 3},
+        {Opcode::Push, Segment::Constant, 2, -1, 4},
+        {Opcode::Eq, Segment::None, 0, -1, 5},
+        {Opcode::If, Segment::None, 0, names.intern("END"), 6}
+    };
+    
+    ostringstream out;
+    CodeWriterWrapper cw(out);
+    cw.setFilename("Main.vm");
+    cw.setPeephole(true);
+    
+    ASSERT_EQ(cw.write(&commands[0], commands.size(), names), 3u);
+    ASSERT_EQ(cw.write(&commands[3], 3, names), 3u);
+    ASSERT_EQ(cw.getRewrites(), 2);
+    
+    string code = withoutAnnotations(out.str());
+    
+    ASSERT_NE(code.find("\t@SP\n\tAM=M-1\n\tD=M\n\t@SP\n\tAM=M-1\n\tD=M-D\n\t@_$END\n\tD;JGE\n"
+                        "\t@2\n\tD=A\n\t@SP\n\tAM=M-1\n\tD=M-D\n\t@_$END\n\tD;JEQ\n"), string::npos);
+}
+
+// not alone is bitwise, so if-goto jumps for every value but -1
+TEST(CodeWriterTest, TestNotAndBranch_peephole)
+{
+    NameTable names;
+    vector<Command> commands{
+        {Opcode::Push, Segment::Constant, 5, -1, 1},
+        {Opcode::Not, Segment::None, 0, -1, 2},
+        {Opcode::If, Segment::None, 0, names.intern("SKIP"), 3}
+    };
+    
+    ostringstream out;
+    CodeWriterWrapper cw(out);
+    cw.setFilename("Main.vm");
+    cw.setPeephole(true);
+    
+    ASSERT_EQ(cw.write(&commands[0], commands.size(), names), 3u);
+    
+    string code = withoutAnnotations(out.str());
+    
+    ASSERT_NE(code.find("\t@5\n\tD=A\n\tD=D+1\n\t@_$SKIP\n\tD;JNE\n"), string::npos);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../src/Folder.h"
+
+using namespace std;
+
+static Command constant(int value)
+{
+    return Command{Opcode::Push, Segment::Constant, value, -1, 1};
+}
+
+static Command operation(Opcode opcode)
+{
+    return Command{opcode, Segment::None, 0, -1, 1};
+}
+
+// constant arithmetic wraps at 16 bits
+TEST(FolderTest, TestConstants_fold)
+{
+    vector<Command> commands{constant(32767), constant(1), operation(Opcode::Add), constant(3), operation(Opcode::Neg), operation(Opcode::Sub)};
+    Folder folder;
+    
+    folder.fold(commands);
+    ASSERT_EQ(commands.size(), 1u);
+    ASSERT_EQ(commands[0].opcode, Opcode::Push);
+    ASSERT_EQ(commands[0].index, -32765);
+    ASSERT_EQ(folder.getFolds(), 3);
+}
+
+// comparisons of constants give -1 or 0, as the generated code would
+TEST(FolderTest, TestComparisons_fold)
+{
+    vector<Command> commands{constant(2), constant(3), operation(Opcode::Lt), constant(5), constant(5), operation(Opcode::Gt)};
+    Folder folder;
+    
+    folder.fold(commands);
+    ASSERT_EQ(commands.size(), 2u);
+    ASSERT_EQ(commands[0].index, -1);
+    ASSERT_EQ(commands[1].index, 0);
+}
+
+// identities are dropped whatever is under them
+TEST(FolderTest, TestIdentities_fold)
+{
+    Command local{Opcode::Push, Segment::Local, 2, -1, 1};
+    vector<Command> commands{local, constant(0), operation(Opcode::Add), operation(Opcode::Not), operation(Opcode::Not),
+                             constant(0), operation(Opcode::Not), operation(Opcode::And)};
+    Folder folder;
+    
+    folder.fold(commands);
+    ASSERT_EQ(commands.size(), 1u);
+    ASSERT_EQ(commands[0].segment, Segment::Local);
+    ASSERT_EQ(folder.getFolds(), 4);
+}
+
+// nothing folds across a label
+TEST(FolderTest, TestLabel_fold)
+{
+    vector<Command> commands{constant(1), operation(Opcode::Label), constant(2), operation(Opcode::Add)};
+    Folder folder;
+    
+    folder.fold(commands);
+    ASSERT_EQ(commands.size(), 4u);
+    ASSERT_EQ(folder.getFolds(), 0);
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../src/Inliner.h"
+
+using namespace std;
+
+static Command command(Opcode opcode, Segment segment = Segment::None, int index = 0, int name = -1)
+{
+    return Command{opcode, segment, index, name, 1};
+}
+
+// a getter's argument is read from under it, and THIS is kept for the caller
+TEST(InlinerTest, TestGetter_inlineCalls)
+{
+    NameTable names;
+    int getter = names.intern("Main.getX");
+    vector<Module> modules{Module{"Main.vm", {
+        command(Opcode::Function, Segment::None, 0, names.intern("Main.main")),
+        command(Opcode::Push, Segment::Constant, 3000),
+        command(Opcode::Call, Segment::None, 1, getter),
+        command(Opcode::Return),
+        command(Opcode::Function, Segment::None, 0, getter),
+        command(Opcode::Push, Segment::Argument, 0),
+        command(Opcode::Pop, Segment::Pointer, 0),
+        command(Opcode::Push, Segment::This, 0),
+        command(Opcode::Return)
+    }}};
+    
+    Inliner inliner(names);
+    inliner.inlineCalls(modules);
+    ASSERT_EQ(inliner.getInlined().size(), 1u);
+    
+    const vector<Command> &commands = modules[0].commands;
+    vector<Command> expected{
+        command(Opcode::Push, Segment::Pointer, 0),
+        command(Opcode::Push, Segment::Stack, 2),
+        command(Opcode::Pop, Segment::Pointer, 0),
+        command(Opcode::Push, Segment::This, 0),
+        command(Opcode::Push, Segment::Stack, 2),
+        command(Opcode::Pop, Segment::Pointer, 0),
+        command(Opcode::Pop, Segment::Stack, 2),
+        command(Opcode::Pop, Segment::Constant, 0)
+    };
+    
+    ASSERT_EQ(commands.size(), 3 + expected.size() + 5);
+    for(size_t i = 0; i < expected.size(); i++)
+    {
+        ASSERT_EQ(commands[2 + i].opcode, expected[i].opcode);
+        ASSERT_EQ(commands[2 + i].segment, expected[i].segment);
+        ASSERT_EQ(commands[2 + i].index, expected[i].index);
+    }
+}
+
+// functions that reach themselves stay calls, and so do calls short of arguments
+TEST(InlinerTest, TestRecursion_inlineCalls)
+{
+    NameTable names;
+    int even = names.intern("Main.even");
+    int odd = names.intern("Main.odd");
+    int first = names.intern("Main.first");
+    vector<Module> modules{Module{"Main.vm", {
+        command(Opcode::Function, Segment::None, 0, even),
+        command(Opcode::Push, Segment::Argument, 0),
+        command(Opcode::Call, Segment::None, 1, odd),
+        command(Opcode::Return),
+        command(Opcode::Function, Segment::None, 0, odd),
+        command(Opcode::Push, Segment::Argument, 0),
+        command(Opcode::Call, Segment::None, 1, even),
+        command(Opcode::Return),
+        command(Opcode::Function, Segment::None, 0, first),
+        command(Opcode::Push, Segment::Argument, 1),
+        command(Opcode::Return),
+        command(Opcode::Call, Segment::None, 1, first)
+    }}};
+    
+    Inliner inliner(names);
+    inliner.inlineCalls(modules);
+    ASSERT_EQ(inliner.getInlined().size(), 0u);
+    ASSERT_EQ(modules[0].commands.size(), 12u);
+}
+
+// labels are renamed for each call, so two copies of a body do not meet
+TEST(InlinerTest, TestLabels_inlineCalls)
+{
+    NameTable names;
+    int skip = names.intern("SKIP");
+    int f = names.intern("Main.f");
+    vector<Module> modules{Module{"Main.vm", {
+        command(Opcode::Function, Segment::None, 0, f),
+        command(Opcode::Push, Segment::Constant, 0),
+        command(Opcode::If, Segment::None, 0, skip),
+        command(Opcode::Label, Segment::None, 0, skip),
+        command(Opcode::Push, Segment::Constant, 1),
+        command(Opcode::Return),
+        command(Opcode::Function, Segment::None, 0, names.intern("Main.main")),
+        command(Opcode::Call, Segment::None, 0, f),
+        command(Opcode::Call, Segment::None, 0, f),
+        command(Opcode::Return)
+    }}};
+    
+    Inliner inliner(names);
+    inliner.inlineCalls(modules);
+    ASSERT_EQ(inliner.getInlined().size(), 2u);
+    
+    vector<string> labels;
+    for(const Command &command : modules[0].commands)
+        if(command.opcode == Opcode::Label)
+            labels.push_back(names.get(command.name));
+    
+    ASSERT_EQ(labels, (vector<string>{"SKIP", "Main.f$SKIP$0", "Main.f$SKIP$1"}));
+}
+
+// with trampolines the shared call and return routines are counted too: the
+// protocol is then a few instructions shorter, but far from only the jumps
+TEST(InlinerTest, TestTrampolines_getSavedCycles)
+{
+    NameTable names;
+    int getter = names.intern("Main.getX");
+    vector<Module> modules{Module{"Main.vm", {
+        command(Opcode::Function, Segment::None, 0, names.intern("Main.main")),
+        command(Opcode::Push, Segment::Constant, 3000),
+        command(Opcode::Call, Segment::None, 1, getter),
+        command(Opcode::Return),
+        command(Opcode::Function, Segment::None, 0, getter),
+        command(Opcode::Push, Segment::Argument, 0),
+        command(Opcode::Pop, Segment::Pointer, 0),
+        command(Opcode::Push, Segment::This, 0),
+        command(Opcode::Return)
+    }}};
+    
+    Inliner inliner(names);
+    inliner.inlineCalls(modules);
+    
+    long inlineForm = inliner.getSavedCycles([](CodeWriter &) {});
+    long trampolines = inliner.getSavedCycles([](CodeWriter &writer) { writer.setTrampolines(true); });
+    
+    ASSERT_GT(inlineForm, 0);
+    ASSERT_GT(trampolines, inlineForm / 2);
+    ASSERT_LE(trampolines, inlineForm);
+}
@@ -161,3 +161,39 @@ TEST(ParserTest, TestCommentsWSAndInput_getLineNumber)
     int lineNumber = p.getLineNumber();
     ASSERT_EQ(lineNumber, 2);
 }
+
+// typed form of a valid command
+TEST(ParserTest, TestValidCommand_getCommand)
+{
+    istringstream input("push local 3\ncall Main.fib 1\nlt\n");
+    Parser p(input);
+    NameTable names;
+    
+    p.advance();
+    Command push = p.getCommand(names);
+    ASSERT_EQ(push.opcode, Opcode::Push);
+    ASSERT_EQ(push.segment, Segment::Local);
+    ASSERT_EQ(push.index, 3);
+    ASSERT_EQ(push.line, 1);
+    
+    p.advance();
+    Command call = p.getCommand(names);
+    ASSERT_EQ(call.opcode, Opcode::Call);
+    ASSERT_EQ(names.get(call.name), "Main.fib");
+    ASSERT_EQ(call.index, 1);
+    ASSERT_EQ(names.intern("Main.fib"), call.name);
+    
+    p.advance();
+    ASSERT_EQ(p.getCommand(names).opcode, Opcode::Lt);
+}
+
+// segment that does not exist
+TEST(ParserTest, TestInvalidSegment_getCommand)
+{
+    istringstream input("pop stack 3");
+    Parser p(input);
+    NameTable names;
+    
+    p.advance();
+    ASSERT_THROW(p.getCommand(names), runtime_error);
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2020 Haresh Bhachandani
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../src/Pruner.h"
+
+using namespace std;
+
+static Command command(Opcode opcode, int index = 0, int name = -1)
+{
+    return Command{opcode, Segment::None, index, name, 1};
+}
+
+// only the functions called, directly or not, from Sys.init are kept
+TEST(PrunerTest, TestReachable_prune)
+{
+    NameTable names;
+    int init = names.intern("Sys.init");
+    int used = names.intern("Math.abs");
+    int nested = names.intern("Math.negate");
+    int unused = names.intern("Math.sqrt");
+    vector<Module> modules{
+        Module{"Sys.vm", {
+            command(Opcode::Function, 0, init),
+            command(Opcode::Call, 0, used),
+            command(Opcode::Return)
+        }},
+        Module{"Math.vm", {
+            command(Opcode::Function, 0, unused),
+            command(Opcode::Call, 0, used),
+            command(Opcode::Return),
+            command(Opcode::Function, 0, used),
+            command(Opcode::Call, 0, nested),
+            command(Opcode::Return),
+            command(Opcode::Function, 0, nested),
+            command(Opcode::Return)
+        }}
+    };
+    
+    Pruner pruner(names);
+    pruner.prune(modules);
+    ASSERT_EQ(pruner.getRemoved(), 1);
+    ASSERT_EQ(modules[0].commands.size(), 3u);
+    ASSERT_EQ(modules[1].commands.size(), 5u);
+    ASSERT_EQ(modules[1].commands[0].name, used);
+    ASSERT_EQ(modules[1].commands[3].name, nested);
+}
+
+// without a Sys.init the program runs from its first command, so all of it stays
+TEST(PrunerTest, TestNoInit_prune)
+{
+    NameTable names;
+    vector<Module> modules{Module{"Main.vm", {
+        command(Opcode::Add),
+        command(Opcode::Function, 0, names.intern("Main.unused")),
+        command(Opcode::Return)
+    }}};
+    
+    Pruner pruner(names);
+    pruner.prune(modules);
+    ASSERT_EQ(pruner.getRemoved(), 0);
+    ASSERT_EQ(modules[0].commands.size(), 3u);
+}